@@ -0,0 +1,25 @@
+//
+//  MTCancellationToken.h
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <Foundation/Foundation.h>
+
+// Shared between the requester of an analysis and the analysis, so that the analysis can be abandoned once its result
+// is no longer needed, e.g. when the user has typed again. The analysis checks the token between passes of the rules.
+// This class is thread safe.
+@interface MTCancellationToken : NSObject
+
++ (instancetype) token;
+
+@property (atomic, readonly, getter=isCancelled) BOOL cancelled;
+
+// Cancels the work using this token. It cannot be undone.
+- (void) cancel;
+
+@end
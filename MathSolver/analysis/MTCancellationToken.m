@@ -0,0 +1,31 @@
+//
+//  MTCancellationToken.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import "MTCancellationToken.h"
+
+@interface MTCancellationToken ()
+
+@property (atomic, readwrite, getter=isCancelled) BOOL cancelled;
+
+@end
+
+@implementation MTCancellationToken
+
++ (instancetype) token
+{
+    return [self new];
+}
+
+- (void) cancel
+{
+    self.cancelled = YES;
+}
+
+@end
@@ -12,6 +12,9 @@
 
 @class MTExpressionCanonicalizer;
 @class MTEquationCanonicalizer;
+@class MTCoalescingCanonicalizer;
+@class MTRuleProfile;
+@class MTCancellationToken;
 
 @protocol MTCanonicalizer <NSObject>
 
@@ -23,6 +26,9 @@
 // i.e. axx + bx +  c
 - (id<MTMathEntity>) normalForm: (id<MTMathEntity>) ex;
 
+// Same as normalForm: but stops and returns nil if the token is cancelled before the normal form is found.
+- (id<MTMathEntity>) normalForm: (id<MTMathEntity>) ex cancellationToken:(MTCancellationToken*) token;
+
 @end
 
 @interface MTCanonicalizerFactory : NSObject
@@ -32,11 +38,23 @@
 
 + (MTExpressionCanonicalizer*) getExpressionCanonicalizer;
 + (MTEquationCanonicalizer*) getEquationCanonicalizer;
+// Returns the singleton instance of the canonicalizer for all entities which coalesces concurrent requests.
++ (MTCoalescingCanonicalizer*) getCoalescingCanonicalizer;
 
 @end
 
 @interface MTExpressionCanonicalizer : NSObject<MTCanonicalizer>
 
+// If not 0, subtrees with at least this many nodes are canonicalized concurrently with their siblings and the
+// numerator and denominator of a rational expression are canonicalized concurrently. The result is the same as
+// canonicalizing serially, which is the default. Only worth it for large expressions.
+@property (nonatomic) NSUInteger parallelThreshold;
+
+// If set, the rules which fire are recorded in the profile and the rules are tried in the order learned by the profile for
+// the class of the expression, which reduces the number of passes needed to reach the normal form. nil (the default)
+// tries the rules in a fixed order.
+@property (nonatomic) MTRuleProfile* ruleProfile;
+
 // Normalize the expression by removing -ves and extra parenthesis.
 - (MTExpression*) normalize: (MTExpression*) ex;
 
@@ -45,6 +63,9 @@
 // i.e. axx + bx +  c
 - (MTExpression*) normalForm: (MTExpression*) ex;
 
+// Same as normalForm: but stops and returns nil if the token is cancelled. The token is checked between passes of the rules.
+- (MTExpression*) normalForm: (MTExpression*) ex cancellationToken:(MTCancellationToken*) token;
+
 @end
 
 @interface MTEquationCanonicalizer : NSString<MTCanonicalizer>
@@ -55,6 +76,37 @@
 // Convert the expression to its normal form equaton representation
 // It assumes that the expression is already normalized using the function above.
 // i.e. xx + bx +  c = 0, with the leading coefficient always 1
+// Linear and quadratic equations in one variable are converted directly from their coefficients without applying the rules.
 - (MTEquation*) normalForm: (MTEquation*) ex;
 
+// Same as normalForm: but stops and returns nil if the token is cancelled.
+- (MTEquation*) normalForm: (MTEquation*) ex cancellationToken:(MTCancellationToken*) token;
+
+// Same as normalForm: but always applies the rules of the expression canonicalizer.
+- (MTEquation*) normalFormUsingRules: (MTEquation*) ex;
+
+// Same as normalFormUsingRules: but stops and returns nil if the token is cancelled.
+- (MTEquation*) normalFormUsingRules: (MTEquation*) ex cancellationToken:(MTCancellationToken*) token;
+
+@end
+
+// Canonicalizes expressions and equations using the canonicalizers above, coalescing concurrent normalForm: requests for the
+// same entity: the first request does the computation, and requests for an identical entity which arrive while it is in flight
+// wait for it and share the result. Entities are identical if they are equal (see isEqual:) and also have the same ranges and
+// number formats, since these are carried over into the result. normalize: is not coalesced. Nothing is cached once the
+// computation completes. This class is thread safe.
+@interface MTCoalescingCanonicalizer : NSObject<MTCanonicalizer>
+
+// Uses the canonicalizer from MTCanonicalizerFactory for each entity.
+- (id) init;
+
+// Uses the given canonicalizer for all entities.
+- (instancetype) initWithCanonicalizer:(id<MTCanonicalizer>) canonicalizer;
+
+// The number of requests which waited for the result of another request instead of computing it.
+@property (nonatomic, readonly) NSUInteger coalescedWaiters;
+
+// Same as normalForm: but returns nil if the token is cancelled, including while waiting for another request.
+- (id<MTMathEntity>) normalForm: (id<MTMathEntity>) ex cancellationToken:(MTCancellationToken*) token;
+
 @end
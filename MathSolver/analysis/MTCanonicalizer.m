@@ -24,6 +24,8 @@
 #import "MTRationalAdditionRule.h"
 #import "MTCancelCommonFactorsRule.h"
 #import "MTRationalMultiplicationRule.h"
+#import "MTRuleProfile.h"
+#import "MTCancellationToken.h"
 
 @class MTExpression;
 
@@ -45,21 +47,33 @@
 + (MTExpressionCanonicalizer *)getExpressionCanonicalizer
 {
     static MTExpressionCanonicalizer* expCanonicalizer = nil;
-    if (!expCanonicalizer) {
+    static dispatch_once_t onceToken = 0;
+    dispatch_once(&onceToken, ^{
         expCanonicalizer = [MTExpressionCanonicalizer new];
-    }
+    });
     return expCanonicalizer;
 }
 
 + (MTEquationCanonicalizer *)getEquationCanonicalizer
 {
     static MTEquationCanonicalizer* eqCanon = nil;
-    if (!eqCanon) {
+    static dispatch_once_t onceToken = 0;
+    dispatch_once(&onceToken, ^{
         eqCanon = [MTEquationCanonicalizer new];
-    }
+    });
     return eqCanon;
 }
 
++ (MTCoalescingCanonicalizer *)getCoalescingCanonicalizer
+{
+    static MTCoalescingCanonicalizer* coalescingCanon = nil;
+    static dispatch_once_t onceToken = 0;
+    dispatch_once(&onceToken, ^{
+        coalescingCanon = [MTCoalescingCanonicalizer new];
+    });
+    return coalescingCanon;
+}
+
 @end
 
 #pragma mark - ExpressionCanonicalizer
@@ -79,20 +93,18 @@
         _removeNegatives = [MTRemoveNegativesRule rule];
         _flatten = [MTFlattenRule rule];
         _reorder = [MTReorderTermsRule rule];
+        // The rewrite rules are matched together in one pass over the expression.
+        MTRewriteRuleSet* simplify = [MTRewriteRuleSet ruleSetCombining:@[[MTNullRule rule], [MTIdentityRule rule], [MTZeroRule rule]]];
         // All rules except division rules
         _canonicalizingRules = @[[MTCalculateRule rule],
-                                 [MTNullRule rule],
-                                 [MTIdentityRule rule],
-                                 [MTZeroRule rule],
+                                 simplify,
                                  [MTDistributionRule rule],
                                  [MTFlattenRule rule],
                                  [MTCollectLikeTermsRule rule],
                                  [MTReduceRule rule]];
         // All rules except distribution with the addition of division rules
         _divisionRules = @[[MTCalculateRule rule],
-                           [MTNullRule rule],
-                           [MTIdentityRule rule],
-                           [MTZeroRule rule],
+                           simplify,
                            [MTFlattenRule rule],
                            [MTNestedDivisionRule rule],
                            [MTCollectLikeTermsRule rule],
@@ -113,23 +125,55 @@
 // Canonicalize the expression to its polynomial representation
 // i.e. axx + bx +  c
 - (MTExpression*) normalForm: (MTExpression*) ex {
-    MTExpression* rationalForm = [self applyRules:_divisionRules toExpression:ex];
+    return [self normalForm:ex cancellationToken:nil];
+}
+
+- (MTExpression*) normalForm:(MTExpression*) ex cancellationToken:(MTCancellationToken*) token
+{
+    MTExpression* rationalForm = [self applyRules:_divisionRules toExpression:ex cancellationToken:token];
+    if (!rationalForm) {
+        return nil;
+    }
     // rationalForm should be of the form polynomial / polynomial
     DLog(@"Rational form: %@", rationalForm);
     if ([MTExpressionUtil isDivision:rationalForm]) {
         NSAssert(rationalForm.children.count == 2, @"Rational form should only have 2 children");
         MTExpression* numerator = rationalForm.children[0];
         MTExpression* denominator = rationalForm.children[1];
+        dispatch_group_t group = nil;
+        __block MTExpression* canonicalNumerator = nil;
+        if (self.parallelThreshold) {
+            // Canonicalize the numerator while the denominator is canonicalized. It is then scaled by the leading coefficient
+            // of the denominator below instead of being canonicalized again.
+            group = dispatch_group_create();
+            dispatch_group_async(group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                canonicalNumerator = [self canonicalFormForPolynomial:numerator cancellationToken:token];
+            });
+        }
         // canonical form for each polynomial
-        MTExpression* canonicalDenonimator = [self canonicalFormForPolynomial:denominator];
+        MTExpression* canonicalDenonimator = [self canonicalFormForPolynomial:denominator cancellationToken:token];
+        if (group) {
+            dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+        }
+        if (!canonicalDenonimator || (group && !canonicalNumerator)) {
+            return nil;
+        }
         // We make always make the leading coefficient of the denominator 1.
         MTRational* leadingCoefficient = [self getLeadingCoefficient:canonicalDenonimator];
-        canonicalDenonimator = [self dividePolynomial:canonicalDenonimator byLeadingCoefficient:leadingCoefficient];
-        MTExpression* canonicalNumerator = [self dividePolynomial:numerator byLeadingCoefficient:leadingCoefficient];
+        canonicalDenonimator = [self dividePolynomial:canonicalDenonimator byLeadingCoefficient:leadingCoefficient cancellationToken:token];
+        if (canonicalNumerator) {
+            MTExpression* scaled = [self scaleCanonicalPolynomial:canonicalNumerator byReciprocalOf:leadingCoefficient];
+            canonicalNumerator = (scaled) ? scaled : [self dividePolynomial:canonicalNumerator byLeadingCoefficient:leadingCoefficient cancellationToken:token];
+        } else {
+            canonicalNumerator = [self dividePolynomial:numerator byLeadingCoefficient:leadingCoefficient cancellationToken:token];
+        }
+        if (!canonicalDenonimator || !canonicalNumerator) {
+            return nil;
+        }
         return [MTOperator operatorWithType:kMTDivision args:canonicalNumerator :canonicalDenonimator];
     } else {
         // canonical form for the polynomial
-        return [self canonicalFormForPolynomial:rationalForm];
+        return [self canonicalFormForPolynomial:rationalForm cancellationToken:token];
     }
 }
 
@@ -144,34 +188,92 @@
     return coefficient;
 }
 
-- (MTExpression*) dividePolynomial:(MTExpression*) expr byLeadingCoefficient:(MTRational*) coefficient
+- (MTExpression*) dividePolynomial:(MTExpression*) expr byLeadingCoefficient:(MTRational*) coefficient cancellationToken:(MTCancellationToken*) token
 {
     // divide by the leading coefficient
     MTExpression* dividedExpr = [MTOperator operatorWithType:kMTDivision args:expr :[MTNumber numberWithValue:coefficient]];
-    return [self canonicalFormForPolynomial:dividedExpr];
+    return [self canonicalFormForPolynomial:dividedExpr cancellationToken:token];
 }
 
-- (MTExpression*) canonicalFormForPolynomial:(MTExpression*) poly
+// Divides each term of a polynomial in canonical form by the coefficient, building the terms the way the rules do: the
+// reduced coefficient in the improper format first, omitted if it is 1, followed by the variables in order. Dividing by a
+// number does not change the order of the terms. Returns nil if a term is not of the form Nxyz.
+- (MTExpression*) scaleCanonicalPolynomial:(MTExpression*) poly byReciprocalOf:(MTRational*) coefficient
 {
-    MTExpression* normalFormPoly = [self applyRules:_canonicalizingRules toExpression:poly];
+    if ([coefficient isEqualToRational:[MTRational one]]) {
+        return poly;
+    }
+    NSArray* terms = (poly.opcode == kMTOpcodeAddition) ? poly.children : @[poly];
+    NSMutableArray* scaledTerms = [NSMutableArray arrayWithCapacity:terms.count];
+    for (MTExpression* term in terms) {
+        MTRational* termCoefficient;
+        NSArray* variables;
+        if (![MTExpressionUtil expression:term getCoefficent:&termCoefficient variables:&variables]) {
+            return nil;
+        }
+        MTRational* value = [[termCoefficient divideBy:coefficient] reduced];
+        NSMutableArray* factors = [NSMutableArray arrayWithCapacity:variables.count + 1];
+        if (variables.count == 0 || ![value isEqualToRational:[MTRational one]]) {
+            [factors addObject:[MTNumber numberWithValue:[MTRational rationalWithNumerator:value.numerator denominator:value.denominator]]];
+        }
+        [factors addObjectsFromArray:variables];
+        [scaledTerms addObject:[MTExpressionUtil combineExpressions:factors withOperatorType:kMTMultiplication]];
+    }
+    return [MTExpressionUtil combineExpressions:scaledTerms withOperatorType:kMTAddition];
+}
+
+// Returns nil if cancelled.
+- (MTExpression*) canonicalFormForPolynomial:(MTExpression*) poly cancellationToken:(MTCancellationToken*) token
+{
+    MTExpression* normalFormPoly = [self applyRules:_canonicalizingRules toExpression:poly cancellationToken:token];
+    if (!normalFormPoly) {
+        return nil;
+    }
     // Order the terms to be in the canonical order.
-    return [_reorder apply:normalFormPoly];
+    return [self applyRule:_reorder toExpression:normalFormPoly];
+}
+
+- (MTExpression*) applyRule:(MTRule*) rule toExpression:(MTExpression*) ex
+{
+    if (self.parallelThreshold) {
+        return [rule apply:ex concurrentlyAboveSize:self.parallelThreshold];
+    }
+    return [rule apply:ex];
 }
 
-- (MTExpression*) applyRules:(NSArray*) rules toExpression:(MTExpression*) ex
+// Applies the rules until none of them change the expression. The token is checked before each pass and nil is returned if
+// it has been cancelled.
+- (MTExpression*) applyRules:(NSArray*) rules toExpression:(MTExpression*) ex cancellationToken:(MTCancellationToken*) token
 {
+    MTRuleProfile* profile = self.ruleProfile;
+    NSString* key = nil;
+    if (profile) {
+        // The rule sets are profiled separately.
+        NSString* ruleSet = (rules == _divisionRules) ? @"division" : @"polynomial";
+        key = [NSString stringWithFormat:@"%@ %@", ruleSet, [MTRuleProfile classOfExpression:ex]];
+        rules = [profile orderRules:rules forKey:key];
+    }
     MTExpression* current = ex;
     BOOL modifed = YES;
+    NSUInteger passes = 0;
     while (modifed) {
+        if (token.isCancelled) {
+            DLog(@"Cancelled canonicalizing %@ after %lu passes", ex, (unsigned long) passes);
+            [profile recordPasses:passes];
+            return nil;
+        }
         modifed = NO;
+        passes++;
         for (MTRule* rule in rules) {
-            MTExpression* next = [rule apply:current];
+            MTExpression* next = [self applyRule:rule toExpression:current];
             if (next != current) {
                 modifed = YES;
                 current = next;
+                [profile recordRule:rule firedForKey:key];
             }
         }
     }
+    [profile recordPasses:passes];
     return current;
 }
 
@@ -190,11 +292,71 @@
 }
 
 - (MTEquation *)normalForm:(MTEquation *)eq
+{
+    return [self normalForm:eq cancellationToken:nil];
+}
+
+- (MTEquation *)normalForm:(MTEquation *)eq cancellationToken:(MTCancellationToken *)token
+{
+    MTEquation* normalForm = [self polynomialNormalForm:eq];
+    if (normalForm) {
+        return normalForm;
+    }
+    return [self normalFormUsingRules:eq cancellationToken:token];
+}
+
+// The normal form computed directly from the coefficients of lhs - rhs if it is a polynomial of degree at most 2 in one variable.
+// Returns nil otherwise, or if lhs - rhs is 0.
+- (MTEquation*) polynomialNormalForm:(MTEquation*) eq
+{
+    MTExpression* difference = [MTOperator operatorWithType:kMTSubtraction args:eq.lhs :eq.rhs];
+    MTVariable* var;
+    NSArray* coefficients = [MTExpressionUtil coefficientsOfPolynomial:difference maxDegree:2 variable:&var];
+    if (coefficients.count == 0) {
+        return nil;
+    }
+    // Build the terms in descending order of degree, with the leading coefficient 1. This is the same as the output of the rules.
+    MTVariable* variable = [MTVariable variableWithName:var.name];
+    MTRational* leadingCoefficient = coefficients.lastObject;
+    NSMutableArray* terms = [NSMutableArray arrayWithCapacity:coefficients.count];
+    for (NSInteger degree = coefficients.count - 1; degree >= 0; degree--) {
+        MTRational* coefficient = [[coefficients[degree] divideBy:leadingCoefficient] reduced];
+        if (coefficient.isZero) {
+            continue;
+        }
+        // The rules always produce numbers in the improper format.
+        MTNumber* number = [MTNumber numberWithValue:[MTRational rationalWithNumerator:coefficient.numerator denominator:coefficient.denominator]];
+        if (degree == 0) {
+            [terms addObject:number];
+            continue;
+        }
+        NSMutableArray* factors = [NSMutableArray arrayWithCapacity:degree + 1];
+        if (![coefficient isEqualToRational:[MTRational one]]) {
+            [factors addObject:number];
+        }
+        for (NSInteger i = 0; i < degree; i++) {
+            [factors addObject:variable];
+        }
+        [terms addObject:[MTExpressionUtil combineExpressions:factors withOperatorType:kMTMultiplication]];
+    }
+    MTExpression* lhs = [MTExpressionUtil combineExpressions:terms withOperatorType:kMTAddition];
+    return [MTEquation equationWithRelation:eq.relation lhs:lhs rhs:[MTNumber numberWithValue:[MTRational zero]]];
+}
+
+- (MTEquation *)normalFormUsingRules:(MTEquation *)eq
+{
+    return [self normalFormUsingRules:eq cancellationToken:nil];
+}
+
+- (MTEquation*) normalFormUsingRules:(MTEquation*) eq cancellationToken:(MTCancellationToken*) token
 {
     MTExpression* newLhs = [MTOperator operatorWithType:kMTSubtraction args:eq.lhs :eq.rhs];
     MTExpressionCanonicalizer* expCanon = [MTCanonicalizerFactory getExpressionCanonicalizer];
     MTExpression* normalizedNewLhs = [expCanon normalize:newLhs];
-    MTExpression* normalForm = [expCanon normalForm:normalizedNewLhs];
+    MTExpression* normalForm = [expCanon normalForm:normalizedNewLhs cancellationToken:token];
+    if (!normalForm) {
+        return nil;
+    }
     
     if (normalForm.expressionType == kMTExpressionTypeNull) {
         InfoLog(@"Equation mathematically invalid: %@", eq);
@@ -209,9 +371,215 @@
     }
     
     MTRational* coefficient = [expCanon getLeadingCoefficient:lhsExpression];
-    lhsExpression = [expCanon dividePolynomial:lhsExpression byLeadingCoefficient:coefficient];
+    lhsExpression = [expCanon dividePolynomial:lhsExpression byLeadingCoefficient:coefficient cancellationToken:token];
+    if (!lhsExpression) {
+        return nil;
+    }
     
     return [MTEquation equationWithRelation:eq.relation lhs:lhsExpression rhs:[MTNumber numberWithValue:[MTRational zero]]];
 }
 
 @end
+
+#pragma mark - CoalescingCanonicalizer
+
+// How often a request waiting for another one checks its own cancellation token.
+static const int64_t kMTCancellationPollInterval = 10 * NSEC_PER_MSEC;
+
+// A computation that other requests can wait on.
+@interface MTInFlightRequest : NSObject
+
+@property (nonatomic, readonly) dispatch_group_t group;
+// Only read after the group is done.
+@property (nonatomic) id<MTMathEntity> result;
+
+@end
+
+@implementation MTInFlightRequest
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        _group = dispatch_group_create();
+        dispatch_group_enter(_group);
+    }
+    return self;
+}
+
+@end
+
+static BOOL isSameRange(MTMathListRange* r1, MTMathListRange* r2)
+{
+    if (!r1 || !r2) {
+        return r1 == r2;
+    }
+    return r1.length == r2.length && [r1.start isEqual:r2.start];
+}
+
+// Expressions which are equal may still differ in their ranges and the formats of their numbers, which are carried over into
+// the normal form. Only called for expressions which are equal.
+static BOOL isIdentical(MTExpression* e1, MTExpression* e2)
+{
+    if (!isSameRange(e1.range, e2.range)) {
+        return NO;
+    }
+    if (e1.expressionType == kMTExpressionTypeNumber && ((MTNumber*) e1).value.format != ((MTNumber*) e2).value.format) {
+        return NO;
+    }
+    NSArray* children1 = e1.children;
+    NSArray* children2 = e2.children;
+    for (NSUInteger i = 0; i < children1.count; i++) {
+        if (!isIdentical(children1[i], children2[i])) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+// The key of a request in flight. Requests are only coalesced if their entities are identical, so that every request gets a
+// result with its own ranges and number formats.
+@interface MTCoalescingKey : NSObject
+
+@property (nonatomic, readonly) id<MTMathEntity> entity;
+
+@end
+
+@implementation MTCoalescingKey
+
++ (instancetype) keyWithEntity:(id<MTMathEntity>) entity
+{
+    MTCoalescingKey* key = [self new];
+    key->_entity = entity;
+    return key;
+}
+
+- (BOOL)isEqual:(id)object
+{
+    if (self == object) {
+        return YES;
+    }
+    if (![object isKindOfClass:[MTCoalescingKey class]]) {
+        return NO;
+    }
+    id<MTMathEntity> other = ((MTCoalescingKey*) object).entity;
+    if (![_entity isEqual:other]) {
+        return NO;
+    }
+    if (_entity.entityType == kMTEquation) {
+        MTEquation* eq1 = (MTEquation*) _entity;
+        MTEquation* eq2 = (MTEquation*) other;
+        return isIdentical(eq1.lhs, eq2.lhs) && isIdentical(eq1.rhs, eq2.rhs);
+    }
+    return isIdentical((MTExpression*) _entity, (MTExpression*) other);
+}
+
+- (NSUInteger)hash
+{
+    return _entity.hash;
+}
+
+@end
+
+@implementation MTCoalescingCanonicalizer {
+    id<MTCanonicalizer> _canonicalizer;
+    // MTCoalescingKey -> MTInFlightRequest
+    NSMapTable* _inFlight;
+    NSUInteger _coalescedWaiters;
+}
+
+- (id) init
+{
+    return [self initWithCanonicalizer:nil];
+}
+
+- (instancetype) initWithCanonicalizer:(id<MTCanonicalizer>) canonicalizer
+{
+    self = [super init];
+    if (self) {
+        _canonicalizer = canonicalizer;
+        _inFlight = [NSMapTable strongToStrongObjectsMapTable];
+    }
+    return self;
+}
+
+- (NSUInteger)coalescedWaiters
+{
+    @synchronized(self) {
+        return _coalescedWaiters;
+    }
+}
+
+- (id<MTCanonicalizer>) canonicalizerForEntity:(id<MTMathEntity>) ex
+{
+    return (_canonicalizer) ? _canonicalizer : [MTCanonicalizerFactory getCanonicalizer:ex];
+}
+
+- (id<MTMathEntity>)normalize:(id<MTMathEntity>)ex
+{
+    // Normalizing is cheap, so it is not coalesced.
+    return [[self canonicalizerForEntity:ex] normalize:ex];
+}
+
+- (id<MTMathEntity>)normalForm:(id<MTMathEntity>)ex
+{
+    return [self normalForm:ex cancellationToken:nil];
+}
+
+- (id<MTMathEntity>)normalForm:(id<MTMathEntity>)ex cancellationToken:(MTCancellationToken *)token
+{
+    return [self coalesceRequestFor:ex cancellationToken:token compute:^id<MTMathEntity>{
+        return [[self canonicalizerForEntity:ex] normalForm:ex cancellationToken:token];
+    }];
+}
+
+// Returns the result of compute for the entity, waiting for a request in flight for an identical entity if there is one.
+// Returns nil if the token is cancelled while waiting.
+- (id<MTMathEntity>) coalesceRequestFor:(id<MTMathEntity>) ex cancellationToken:(MTCancellationToken*) token
+                                compute:(id<MTMathEntity> (^)(void)) compute
+{
+    MTCoalescingKey* key = [MTCoalescingKey keyWithEntity:ex];
+    while (true) {
+        MTInFlightRequest* request;
+        BOOL waiting = NO;
+        @synchronized(self) {
+            request = [_inFlight objectForKey:key];
+            if (request) {
+                waiting = YES;
+                _coalescedWaiters++;
+            } else {
+                request = [MTInFlightRequest new];
+                [_inFlight setObject:request forKey:key];
+            }
+        }
+
+        if (!waiting) {
+            @try {
+                request.result = compute();
+            } @finally {
+                @synchronized(self) {
+                    [_inFlight removeObjectForKey:key];
+                }
+                dispatch_group_leave(request.group);
+            }
+            return request.result;
+        }
+
+        // The token can't signal the group, so check it periodically while waiting.
+        while (dispatch_group_wait(request.group, dispatch_time(DISPATCH_TIME_NOW, kMTCancellationPollInterval)) != 0) {
+            if (token.isCancelled) {
+                return nil;
+            }
+        }
+        if (token.isCancelled) {
+            return nil;
+        }
+        if (request.result) {
+            return request.result;
+        }
+        // The request we waited for was cancelled by its own token, so try again.
+        DLog(@"Coalesced request for %@ was cancelled, retrying", ex);
+    }
+}
+
+@end
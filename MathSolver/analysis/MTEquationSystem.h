@@ -0,0 +1,42 @@
+//
+//  MTEquationSystem.h
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <Foundation/Foundation.h>
+#import "MTExpression.h"
+
+// A system of equations in one or more variables, e.g. x + y = 3, x - y = 1.
+// Linear systems are solved exactly using fraction free (Bareiss) elimination, so all the intermediate values are integers.
+// These are minors of the matrix, which overflow an NSInteger for dense systems of around 10 variables or more even when the
+// solution is small. Such systems are solved modulo large primes instead, which works for any number of variables as long as
+// the numerators and denominators of the solution are below 2^61.
+@interface MTEquationSystem : NSObject
+
++ (instancetype) systemWithEquations:(NSArray*) equations;
+
+// The MTEquations in the system.
+@property (nonatomic, readonly) NSArray* equations;
+// The MTVariables in the system sorted by name.
+@property (nonatomic, readonly) NSArray* variables;
+
+- (NSString*) stringValue;
+
+// Returns the coefficients of each equation (in the order of variables) followed by the constant term on the rhs,
+// computed from the normal form of lhs - rhs. Returns nil if any of the equations is not linear.
+- (NSArray*) augmentedMatrix;
+
+// Solves the system and returns an equation of the form x = value for each variable in the order of variables.
+// Returns nil if the system is not linear, does not have a unique solution or the solution is too large to represent exactly.
+- (NSArray*) solve;
+
+// Solves the linear system given as rows of MTRationals of the form a1 a2 ... an b for a1x1 + a2x2 + ... + anxn = b.
+// Returns the MTRational values of x1 ... xn or nil if there is no unique solution or the solution is too large.
++ (NSArray*) solveAugmentedMatrix:(NSArray*) matrix;
+
+@end
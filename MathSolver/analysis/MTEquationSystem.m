@@ -0,0 +1,447 @@
+//
+//  MTEquationSystem.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import "MTEquationSystem.h"
+#import "MTCanonicalizer.h"
+#import "MTExpressionUtil.h"
+
+#pragma mark - Integer arithmetic
+
+// The elimination is done on NSIntegers with overflow checks, since MTRational does not check for overflows.
+// All of these return NO on overflow.
+
+static BOOL multiply(NSInteger a, NSInteger b, NSInteger* result) {
+    return !__builtin_mul_overflow(a, b, result);
+}
+
+// a*b - c*d
+static BOOL crossDifference(NSInteger a, NSInteger b, NSInteger c, NSInteger d, NSInteger* result) {
+    NSInteger ab, cd;
+    return multiply(a, b, &ab) && multiply(c, d, &cd) && !__builtin_sub_overflow(ab, cd, result);
+}
+
+static NSInteger gcd(NSInteger a, NSInteger b) {
+    a = ABS(a);
+    b = ABS(b);
+    while (b != 0) {
+        NSInteger prev = b;
+        b = a % b;
+        a = prev;
+    }
+    return a;
+}
+
+// Scales the row of rationals by the lcm of the denominators and writes the integer row to out.
+static BOOL integerRow(NSArray* row, NSInteger* out) {
+    NSInteger lcm = 1;
+    for (MTRational* value in row) {
+        MTRational* reduced = value.reduced;
+        NSInteger denominator = ABS(reduced.denominator);
+        if (!multiply(lcm / gcd(lcm, denominator), denominator, &lcm)) {
+            return NO;
+        }
+    }
+    for (NSUInteger j = 0; j < row.count; j++) {
+        MTRational* reduced = [row[j] reduced];
+        NSInteger numerator = (reduced.denominator < 0) ? -reduced.numerator : reduced.numerator;
+        if (!multiply(numerator, lcm / ABS(reduced.denominator), &out[j])) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+// Fraction free Gaussian elimination of the n x (m + 1) row major matrix a in place. Every division is exact.
+// Returns the solution as numerators over the common denominator det, or NO if there is no unique solution or on overflow.
+static BOOL bareiss(NSInteger* a, NSUInteger n, NSUInteger m, NSInteger* y, NSInteger* det) {
+    if (n < m) {
+        return NO;
+    }
+    const NSUInteger cols = m + 1;
+    NSInteger previous = 1;
+    for (NSUInteger k = 0; k < m; k++) {
+        // Find a pivot for column k
+        NSUInteger pivot = k;
+        while (pivot < n && a[pivot * cols + k] == 0) {
+            pivot++;
+        }
+        if (pivot == n) {
+            // The column is dependent on the previous ones, so there are infinitely many or no solutions.
+            return NO;
+        }
+        if (pivot != k) {
+            for (NSUInteger j = 0; j < cols; j++) {
+                NSInteger temp = a[k * cols + j];
+                a[k * cols + j] = a[pivot * cols + j];
+                a[pivot * cols + j] = temp;
+            }
+        }
+        NSInteger* pivotRow = &a[k * cols];
+        for (NSUInteger i = k + 1; i < n; i++) {
+            NSInteger* row = &a[i * cols];
+            for (NSUInteger j = k + 1; j < cols; j++) {
+                NSInteger value;
+                if (!crossDifference(pivotRow[k], row[j], row[k], pivotRow[j], &value)) {
+                    return NO;
+                }
+                // By Sylvester's identity this is exact.
+                row[j] = value / previous;
+            }
+            row[k] = 0;
+        }
+        previous = pivotRow[k];
+    }
+    // Any remaining equations must have been reduced to 0 = 0.
+    for (NSUInteger i = m; i < n; i++) {
+        if (a[i * cols + m] != 0) {
+            return NO;
+        }
+    }
+
+    // The last pivot is the determinant (up to sign). Fraction free back substitution gives det * x, which are integers.
+    *det = previous;
+    for (NSInteger i = (NSInteger) m - 1; i >= 0; i--) {
+        NSInteger* row = &a[i * cols];
+        NSInteger sum;
+        if (!multiply(previous, row[m], &sum)) {
+            return NO;
+        }
+        for (NSUInteger l = i + 1; l < m; l++) {
+            NSInteger term;
+            if (!multiply(row[l], y[l], &term) || __builtin_sub_overflow(sum, term, &sum)) {
+                return NO;
+            }
+        }
+        y[i] = sum / row[i];
+    }
+    return YES;
+}
+
+#pragma mark - Modular elimination
+
+// When the minors overflow, the system is solved modulo primes below 2^62 and the rational solution is reconstructed from the
+// solutions modulo two primes by the chinese remainder theorem. This finds every solution whose numerators and denominators
+// are below sqrt(p1 * p2 / 2), i.e. about 2^61, independent of the size of the intermediate values.
+static const uint64_t kMTPrimes[] = { 4611686018427387847ull, 4611686018427387817ull, 4611686018427387787ull,
+                                      4611686018427387761ull, 4611686018427387751ull, 4611686018427387737ull };
+static const NSUInteger kMTPrimeCount = sizeof(kMTPrimes) / sizeof(kMTPrimes[0]);
+
+static uint64_t mulMod(uint64_t a, uint64_t b, uint64_t p) {
+    return (uint64_t) (((unsigned __int128) a * b) % p);
+}
+
+static uint64_t inverseMod(uint64_t a, uint64_t p) {
+    // By Fermat's little theorem a^(p - 2) is the inverse of a.
+    uint64_t result = 1;
+    for (uint64_t e = p - 2; e > 0; e >>= 1) {
+        if (e & 1) {
+            result = mulMod(result, a, p);
+        }
+        a = mulMod(a, a, p);
+    }
+    return result;
+}
+
+// Gaussian elimination of the n x (m + 1) row major matrix a modulo p, using r as scratch space.
+// Returns the solution modulo p in x, or NO if the system does not have a unique solution modulo p.
+static BOOL solveModulo(const NSInteger* a, NSUInteger n, NSUInteger m, uint64_t p, uint64_t* r, uint64_t* x) {
+    const NSUInteger cols = m + 1;
+    for (NSUInteger i = 0; i < n * cols; i++) {
+        NSInteger value = a[i] % (NSInteger) p;
+        r[i] = (value < 0) ? (uint64_t) (value + (NSInteger) p) : (uint64_t) value;
+    }
+    for (NSUInteger k = 0; k < m; k++) {
+        NSUInteger pivot = k;
+        while (pivot < n && r[pivot * cols + k] == 0) {
+            pivot++;
+        }
+        if (pivot == n) {
+            return NO;
+        }
+        if (pivot != k) {
+            for (NSUInteger j = 0; j < cols; j++) {
+                uint64_t temp = r[k * cols + j];
+                r[k * cols + j] = r[pivot * cols + j];
+                r[pivot * cols + j] = temp;
+            }
+        }
+        // Scale the pivot row so that the pivot is 1 and eliminate the column from all the other rows.
+        uint64_t* pivotRow = &r[k * cols];
+        uint64_t inverse = inverseMod(pivotRow[k], p);
+        for (NSUInteger j = k; j < cols; j++) {
+            pivotRow[j] = mulMod(pivotRow[j], inverse, p);
+        }
+        for (NSUInteger i = 0; i < n; i++) {
+            uint64_t factor = r[i * cols + k];
+            if (i == k || factor == 0) {
+                continue;
+            }
+            uint64_t* row = &r[i * cols];
+            for (NSUInteger j = k; j < cols; j++) {
+                // Both are below 2^62 so the difference does not overflow.
+                uint64_t product = mulMod(factor, pivotRow[j], p);
+                row[j] = (row[j] >= product) ? row[j] - product : row[j] + p - product;
+            }
+        }
+    }
+    for (NSUInteger i = m; i < n; i++) {
+        if (r[i * cols + m] != 0) {
+            return NO;
+        }
+    }
+    for (NSUInteger i = 0; i < m; i++) {
+        x[i] = r[i * cols + m];
+    }
+    return YES;
+}
+
+// Finds numerator / denominator congruent to value modulo modulus with both below sqrt(modulus / 2).
+static BOOL reconstructRational(unsigned __int128 value, unsigned __int128 modulus, NSInteger* numerator, NSInteger* denominator) {
+    // The bound is the integer square root of modulus / 2, computed a bit at a time.
+    unsigned __int128 half = modulus / 2;
+    unsigned __int128 bound = 0;
+    for (int bit = 63; bit >= 0; bit--) {
+        unsigned __int128 candidate = bound | ((unsigned __int128) 1 << bit);
+        if (candidate * candidate <= half) {
+            bound = candidate;
+        }
+    }
+    __int128 r0 = (__int128) modulus, r1 = (__int128) value;
+    __int128 t0 = 0, t1 = 1;
+    while ((unsigned __int128) r1 > bound) {
+        __int128 q = r0 / r1;
+        __int128 r2 = r0 - q * r1;
+        __int128 t2 = t0 - q * t1;
+        r0 = r1;
+        r1 = r2;
+        t0 = t1;
+        t1 = t2;
+    }
+    __int128 d = (t1 < 0) ? -t1 : t1;
+    if (d == 0 || (unsigned __int128) d > bound) {
+        return NO;
+    }
+    __int128 n = (t1 < 0) ? -r1 : r1;
+    // The bound is below 2^62 so both fit in an NSInteger.
+    *numerator = (NSInteger) n;
+    *denominator = (NSInteger) d;
+    return YES;
+}
+
+// Checks that the rationals numerators / denominators solve the n x (m + 1) integer system exactly.
+static BOOL isSolution(const NSInteger* a, NSUInteger n, NSUInteger m, const NSInteger* numerators, const NSInteger* denominators) {
+    __int128 lcm = 1;
+    for (NSUInteger j = 0; j < m; j++) {
+        __int128 x = lcm, y = denominators[j];
+        while (y != 0) {
+            __int128 prev = y;
+            y = x % y;
+            x = prev;
+        }
+        if (__builtin_mul_overflow(lcm / x, (__int128) denominators[j], &lcm)) {
+            return NO;
+        }
+    }
+    const NSUInteger cols = m + 1;
+    for (NSUInteger i = 0; i < n; i++) {
+        __int128 sum = 0;
+        for (NSUInteger j = 0; j < m; j++) {
+            __int128 term;
+            if (__builtin_mul_overflow((__int128) numerators[j], lcm / denominators[j], &term)
+                || __builtin_mul_overflow(term, (__int128) a[i * cols + j], &term)
+                || __builtin_add_overflow(sum, term, &sum)) {
+                return NO;
+            }
+        }
+        __int128 rhs;
+        if (__builtin_mul_overflow((__int128) a[i * cols + m], lcm, &rhs) || sum != rhs) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+// Solves the n x (m + 1) integer system modulo primes and returns the solution as numerators / denominators.
+// Returns NO if the system does not have a unique solution or the solution is too large to reconstruct.
+static BOOL solveModular(const NSInteger* a, NSUInteger n, NSUInteger m, NSInteger* numerators, NSInteger* denominators) {
+    if (n < m) {
+        return NO;
+    }
+    uint64_t* r = malloc(n * (m + 1) * sizeof(uint64_t));
+    uint64_t* solutions = malloc(2 * MAX(m, 1) * sizeof(uint64_t));
+    uint64_t* previous = solutions;
+    uint64_t* current = solutions + MAX(m, 1);
+    NSInteger previousPrime = -1;
+    BOOL solved = NO;
+    for (NSUInteger k = 0; k < kMTPrimeCount && !solved; k++) {
+        uint64_t p = kMTPrimes[k];
+        if (!solveModulo(a, n, m, p, r, current)) {
+            // Either the system has no unique solution or p divides its determinant.
+            continue;
+        }
+        if (previousPrime >= 0) {
+            // Combine with the solution for the previous prime q: x = x_q + q * ((x_p - x_q) / q mod p).
+            uint64_t q = kMTPrimes[previousPrime];
+            uint64_t qInverse = inverseMod(q % p, p);
+            unsigned __int128 modulus = (unsigned __int128) q * p;
+            solved = YES;
+            for (NSUInteger j = 0; j < m && solved; j++) {
+                uint64_t xq = previous[j] % p;
+                uint64_t difference = (current[j] >= xq) ? current[j] - xq : current[j] + p - xq;
+                unsigned __int128 value = previous[j] + (unsigned __int128) q * mulMod(difference, qInverse, p);
+                solved = reconstructRational(value, modulus, &numerators[j], &denominators[j]);
+            }
+            // An unlucky prime can give a wrong solution, which is caught here.
+            solved = solved && isSolution(a, n, m, numerators, denominators);
+        }
+        uint64_t* temp = previous;
+        previous = current;
+        current = temp;
+        previousPrime = k;
+    }
+    free(r);
+    free(solutions);
+    return solved;
+}
+
+#pragma mark - MTEquationSystem
+
+@implementation MTEquationSystem
+
++ (instancetype) systemWithEquations:(NSArray*) equations
+{
+    MTEquationSystem* system = [self new];
+    system->_equations = [equations copy];
+    NSMutableSet* variables = [NSMutableSet set];
+    for (MTEquation* eq in equations) {
+        [variables unionSet:[MTExpressionUtil getVariablesInExpression:eq.lhs]];
+        [variables unionSet:[MTExpressionUtil getVariablesInExpression:eq.rhs]];
+    }
+    system->_variables = [variables.allObjects sortedArrayUsingComparator:^NSComparisonResult(MTVariable* var1, MTVariable* var2) {
+        if (var1.name < var2.name) {
+            return NSOrderedAscending;
+        } else if (var1.name > var2.name) {
+            return NSOrderedDescending;
+        }
+        return NSOrderedSame;
+    }];
+    return system;
+}
+
+- (NSString *)stringValue
+{
+    return [[self.equations valueForKey:@"stringValue"] componentsJoinedByString:@", "];
+}
+
+- (NSString *)description
+{
+    return self.stringValue;
+}
+
+- (NSArray*) augmentedMatrix
+{
+    MTExpressionCanonicalizer* canonicalizer = [MTCanonicalizerFactory getExpressionCanonicalizer];
+    NSUInteger count = self.variables.count;
+    NSMutableArray* matrix = [NSMutableArray arrayWithCapacity:self.equations.count];
+    for (MTEquation* eq in self.equations) {
+        MTExpression* difference = [MTOperator operatorWithType:kMTSubtraction args:eq.lhs :eq.rhs];
+        MTExpression* normalForm = [canonicalizer normalForm:[canonicalizer normalize:difference]];
+        NSMutableArray* row = [NSMutableArray arrayWithCapacity:count + 1];
+        for (NSUInteger i = 0; i <= count; i++) {
+            [row addObject:[MTRational zero]];
+        }
+        NSArray* terms = [MTExpressionUtil isAddition:normalForm] ? normalForm.children : @[normalForm];
+        for (MTExpression* term in terms) {
+            MTRational* coefficient;
+            NSArray* vars;
+            if (![MTExpressionUtil expression:term getCoefficent:&coefficient variables:&vars] || vars.count > 1) {
+                // A null, a division or a term of degree > 1.
+                InfoLog(@"Equation %@ is not linear", eq);
+                return nil;
+            }
+            if (vars.count == 0) {
+                // The constant moves to the rhs.
+                row[count] = coefficient.negation;
+            } else {
+                row[[self.variables indexOfObject:vars[0]]] = coefficient;
+            }
+        }
+        [matrix addObject:row];
+    }
+    return matrix;
+}
+
+- (NSArray*) solve
+{
+    NSArray* matrix = [self augmentedMatrix];
+    if (!matrix) {
+        return nil;
+    }
+    NSArray* values = [MTEquationSystem solveAugmentedMatrix:matrix];
+    if (!values) {
+        InfoLog(@"System %@ does not have a unique solution", self);
+        return nil;
+    }
+    NSMutableArray* solution = [NSMutableArray arrayWithCapacity:values.count];
+    for (NSUInteger i = 0; i < values.count; i++) {
+        [solution addObject:[MTEquation equationWithRelation:'=' lhs:self.variables[i] rhs:[MTNumber numberWithValue:values[i]]]];
+    }
+    return solution;
+}
+
++ (NSArray*) solveAugmentedMatrix:(NSArray*) matrix
+{
+    NSUInteger n = matrix.count;
+    if (n == 0 || [matrix[0] count] == 0) {
+        return nil;
+    }
+    NSUInteger m = [matrix[0] count] - 1;
+    NSInteger* a = malloc(n * (m + 1) * sizeof(NSInteger));
+    NSInteger* y = malloc(2 * MAX(m, 1) * sizeof(NSInteger));
+    NSInteger det = 0;
+    BOOL integral = [self integerMatrix:matrix rows:n columns:m + 1 into:a];
+    NSMutableArray* values = nil;
+    if (integral && bareiss(a, n, m, y, &det)) {
+        values = [NSMutableArray arrayWithCapacity:m];
+        // Keep the denominator positive.
+        NSInteger sign = (det < 0) ? -1 : 1;
+        for (NSUInteger i = 0; i < m; i++) {
+            [values addObject:[[MTRational rationalWithNumerator:sign * y[i] denominator:sign * det] reduced]];
+        }
+    } else if (integral) {
+        // The minors overflow for dense systems of around 10 variables or more even when the solution is small, so solve it
+        // modulo primes instead. The elimination above works in place, so convert the matrix again.
+        NSInteger* numerators = y;
+        NSInteger* denominators = y + MAX(m, 1);
+        [self integerMatrix:matrix rows:n columns:m + 1 into:a];
+        if (solveModular(a, n, m, numerators, denominators)) {
+            values = [NSMutableArray arrayWithCapacity:m];
+            for (NSUInteger i = 0; i < m; i++) {
+                [values addObject:[[MTRational rationalWithNumerator:numerators[i] denominator:denominators[i]] reduced]];
+            }
+        }
+    }
+    free(a);
+    free(y);
+    return values;
+}
+
++ (BOOL) integerMatrix:(NSArray*) matrix rows:(NSUInteger) n columns:(NSUInteger) cols into:(NSInteger*) a
+{
+    for (NSUInteger i = 0; i < n; i++) {
+        NSAssert([matrix[i] count] == cols, @"Row %@ does not have %lu entries", matrix[i], (unsigned long) cols);
+        if (!integerRow(matrix[i], &a[i * cols])) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+@end
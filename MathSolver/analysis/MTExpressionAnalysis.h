@@ -11,10 +11,20 @@
 
 #import "MTExpressionInfo.h"
 
+@class MTCancellationToken;
+
+typedef void (^MTAnalysisCompletion)(MTExpressionInfo* info, BOOL hasCheckableAnswer);
+
 @interface MTExpressionAnalysis : NSObject
 
 + (BOOL)hasCheckableAnswer:(MTExpressionInfo*) start;
 
+// Creates the MTExpressionInfo for the expression and checks hasCheckableAnswer: on a background queue, then calls completion
+// on the given queue. If the token is cancelled, e.g. because the user typed again, the analysis stops after the current pass
+// of the rules and completion is never called. The token may be nil.
++ (void) analyzeExpression:(id<MTMathEntity>) expression input:(MTMathList*) input cancellationToken:(MTCancellationToken*) token
+                     queue:(dispatch_queue_t) queue completion:(MTAnalysisCompletion) completion;
+
 + (BOOL) isExpressionFinalStep:(MTExpressionInfo*) expressionInfo forEntityType:(MTMathEntityType) originalEntityType;
 
 @end
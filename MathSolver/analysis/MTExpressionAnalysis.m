@@ -14,6 +14,8 @@
 #import "MTExpressionUtil.h"
 #import "MTReorderTermsRule.h"
 #import "MTDecimalReduceRule.h"
+#import "MTCancellationToken.h"
+#import "MTTrace.h"
 
 @implementation MTExpressionAnalysis
 
@@ -43,11 +45,26 @@
 
 + (BOOL) isReducedEquationSide:(MTExpression*) expr
 {
+    if (expr.expressionType != kMTExpressionTypeNumber) {
+        return NO;
+    }
     MTExpressionInfo* exprInfo = [[MTExpressionInfo alloc] initWithExpression:expr input:nil];
-    return expr.expressionType == kMTExpressionTypeNumber && [self isReducedExpression:expr withNormalForm:exprInfo.normalForm];
+    return [self isReducedExpression:expr withNormalForm:exprInfo.normalForm];
 }
 
 + (BOOL)hasCheckableAnswer:(MTExpressionInfo*) start
+{
+    MTTraceRecorder* recorder = [MTTraceRecorder sharedRecorder];
+    if (!recorder) {
+        return [self isCheckable:start];
+    }
+    CFAbsoluteTime begin = CFAbsoluteTimeGetCurrent();
+    BOOL checkable = [self isCheckable:start];
+    [recorder recordStage:kMTTraceStageAnalysis forEntity:start.original duration:CFAbsoluteTimeGetCurrent() - begin];
+    return checkable;
+}
+
++ (BOOL) isCheckable:(MTExpressionInfo*) start
 {
     id<MTMathEntity> expr = start.original;
     if ([self isExpressionFinalStep:start forEntityType:expr.entityType]) {
@@ -108,4 +125,25 @@
     
     return YES;
 }
+
++ (void)analyzeExpression:(id<MTMathEntity>)expression input:(MTMathList *)input cancellationToken:(MTCancellationToken *)token
+                    queue:(dispatch_queue_t)queue completion:(MTAnalysisCompletion)completion
+{
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        if (token.isCancelled) {
+            return;
+        }
+        MTExpressionInfo* info = [[MTExpressionInfo alloc] initWithExpression:expression input:input];
+        if (![info computeNormalFormWithCancellationToken:token]) {
+            DLog(@"Analysis of %@ cancelled", expression);
+            return;
+        }
+        BOOL checkable = [self hasCheckableAnswer:info];
+        dispatch_async(queue, ^{
+            if (!token.isCancelled) {
+                completion(info, checkable);
+            }
+        });
+    });
+}
 @end
@@ -11,7 +11,11 @@
 #import "MTExpression.h"
 #import "MTMathList.h"
 
+@class MTCancellationToken;
+
 // Information about an expression
+// The normalized expression and the normal form are computed lazily on first access, so callers that only need the
+// normalized expression do not pay for the normal form. Accessing them is thread safe.
 @interface MTExpressionInfo : NSObject
 
 // Create an ExpressionInfo object with the parsed expression, the original unparsed input MTMathList and if present a variableName
@@ -23,6 +27,14 @@
 
 - (NSString *)description;
 
+// Computes the normalized expression and the normal form of each of the given MTExpressionInfo objects concurrently.
+// Returns once they are all computed.
++ (void) computeNormalForms:(NSArray*) expressionInfos;
+
+// Computes the normalized expression and the normal form unless the token is cancelled first. Returns NO if it was cancelled,
+// in which case the normal form is computed again on the next access.
+- (BOOL) computeNormalFormWithCancellationToken:(MTCancellationToken*) token;
+
 // The original expression as displayed
 @property (nonatomic, readonly) id<MTMathEntity> original;
 // Normalized form of the expression
@@ -34,4 +46,8 @@
 // The original input from the user.
 @property (nonatomic, readonly) MTMathList* input;
 
+// The number of bytes of memory used by the original expression and by the normalized expression and normal form if they
+// have been computed. Subexpressions shared between them are counted once. The input is not counted.
+- (NSUInteger) retainedBytes;
+
 @end
@@ -8,10 +8,58 @@
 //  MIT license. See the LICENSE file for details.
 //
 
+#import <malloc/malloc.h>
+
 #import "MTExpressionInfo.h"
 #import "MTCanonicalizer.h"
+#import "MTTrace.h"
+
+// The size of the allocation for the object if it has not been counted already.
+static NSUInteger objectBytes(id object, NSHashTable* counted) {
+    if (!object || [counted containsObject:object]) {
+        return 0;
+    }
+    [counted addObject:object];
+    return malloc_size((__bridge const void*) object);
+}
+
+static NSUInteger entityBytes(id<MTMathEntity> entity, NSHashTable* counted) {
+    if (!entity || [counted containsObject:entity]) {
+        return 0;
+    }
+    if (entity.entityType == kMTEquation) {
+        MTEquation* eq = (MTEquation*) entity;
+        return objectBytes(eq, counted) + entityBytes(eq.lhs, counted) + entityBytes(eq.rhs, counted);
+    }
+    MTExpression* expr = (MTExpression*) entity;
+    NSUInteger bytes = objectBytes(expr, counted) + objectBytes(expr.range, counted);
+    switch (expr.expressionType) {
+        case kMTExpressionTypeNumber:
+            bytes += objectBytes(((MTNumber*) expr).value, counted);
+            break;
+
+        case kMTExpressionTypeOperator:
+            bytes += objectBytes(expr.children, counted);
+            for (MTExpression* child in expr.children) {
+                bytes += entityBytes(child, counted);
+            }
+            break;
+
+        case kMTExpressionTypeVariable:
+        case kMTExpressionTypeNull:
+            break;
+    }
+    return bytes;
+}
 
-@implementation MTExpressionInfo
+@implementation MTExpressionInfo {
+    id<MTCanonicalizer> _canonicalizer;
+    id<MTMathEntity> _normalized;
+    id<MTMathEntity> _normalForm;
+    // Each stage has its own lock, so that reading the normalized expression does not wait for the normal form.
+    NSObject* _normalizedLock;
+    NSObject* _normalFormLock;
+}
 
 - (id)initWithExpression:(id<MTMathEntity>)expression input:(MTMathList *)input
 {
@@ -28,17 +76,93 @@
     self = [super init];
     if (self) {
         if (expression) {
-            id<MTCanonicalizer> canonicalizer = [MTCanonicalizerFactory getCanonicalizer:expression];
+            // Students often submit the same expression at the same time, so share the computation.
+            _canonicalizer = [MTCanonicalizerFactory getCoalescingCanonicalizer];
             _original = expression;
-            _normalized = [canonicalizer normalize:expression];
-            _normalForm = [canonicalizer normalForm:_normalized];
         }
         _input = input;
         _variableName = [variable copy];
+        _normalizedLock = [NSObject new];
+        _normalFormLock = [NSObject new];
     }
     return self;
 }
 
+- (id<MTMathEntity>)normalized
+{
+    @synchronized(_normalizedLock) {
+        if (!_normalized && _original) {
+            MTTraceRecorder* recorder = [MTTraceRecorder sharedRecorder];
+            CFAbsoluteTime start = (recorder) ? CFAbsoluteTimeGetCurrent() : 0;
+            _normalized = [_canonicalizer normalize:_original];
+            if (recorder) {
+                [recorder recordStage:kMTTraceStageNormalize forEntity:_original duration:CFAbsoluteTimeGetCurrent() - start];
+            }
+        }
+        return _normalized;
+    }
+}
+
+- (id<MTMathEntity>)normalForm
+{
+    // Computed before taking the normal form lock, which is not held while normalizing.
+    id<MTMathEntity> normalized = self.normalized;
+    @synchronized(_normalFormLock) {
+        if (!_normalForm && _original) {
+            MTTraceRecorder* recorder = [MTTraceRecorder sharedRecorder];
+            CFAbsoluteTime start = (recorder) ? CFAbsoluteTimeGetCurrent() : 0;
+            _normalForm = [_canonicalizer normalForm:normalized];
+            if (recorder) {
+                [recorder recordStage:kMTTraceStageNormalForm forEntity:_original duration:CFAbsoluteTimeGetCurrent() - start];
+            }
+        }
+        return _normalForm;
+    }
+}
+
+- (BOOL)computeNormalFormWithCancellationToken:(MTCancellationToken *)token
+{
+    id<MTMathEntity> normalized = self.normalized;
+    @synchronized(_normalFormLock) {
+        if (!_normalForm && _original) {
+            MTTraceRecorder* recorder = [MTTraceRecorder sharedRecorder];
+            CFAbsoluteTime start = (recorder) ? CFAbsoluteTimeGetCurrent() : 0;
+            id<MTMathEntity> normalForm = [_canonicalizer normalForm:normalized cancellationToken:token];
+            if (!normalForm) {
+                return NO;
+            }
+            if (recorder) {
+                [recorder recordStage:kMTTraceStageNormalForm forEntity:_original duration:CFAbsoluteTimeGetCurrent() - start];
+            }
+            _normalForm = normalForm;
+        }
+        return YES;
+    }
+}
+
++ (void)computeNormalForms:(NSArray *)expressionInfos
+{
+    dispatch_apply(expressionInfos.count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        MTExpressionInfo* info = expressionInfos[i];
+        [info normalForm];
+    });
+}
+
+- (NSUInteger)retainedBytes
+{
+    // Compare by pointer since equal expressions may be different objects.
+    NSHashTable* counted = [[NSHashTable alloc] initWithOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality capacity:0];
+    id<MTMathEntity> normalized;
+    id<MTMathEntity> normalForm;
+    @synchronized(_normalizedLock) {
+        normalized = _normalized;
+    }
+    @synchronized(_normalFormLock) {
+        normalForm = _normalForm;
+    }
+    return entityBytes(_original, counted) + entityBytes(normalized, counted) + entityBytes(normalForm, counted);
+}
+
 - (NSString *)description
 {
     NSMutableString *str = [NSMutableString string];
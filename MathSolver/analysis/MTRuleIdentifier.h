@@ -0,0 +1,44 @@
+//
+//  MTRuleIdentifier.h
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <Foundation/Foundation.h>
+#import "MTExpression.h"
+
+@class MTRule;
+
+// The rule that transforms one step of a derivation into the next.
+@interface MTRuleIdentification : NSObject
+
+// The rule that was applied.
+@property (nonatomic, readonly) MTRule* rule;
+// The location of the subexpression the rule was applied to, as a path of child indices from the root of the previous step.
+// The empty path is the root.
+@property (nonatomic, readonly) NSIndexPath* location;
+// The subexpression of the previous step that the rule was applied to.
+@property (nonatomic, readonly) MTExpression* before;
+// The subexpression of the next step that it was transformed to.
+@property (nonatomic, readonly) MTExpression* after;
+
+@end
+
+// Identifies which MTRule transforms an expression into another. Instead of trying every rule at every position, the changed
+// subexpression is localized by a structural diff of the two trees and only the rules which apply to that kind of subexpression are tried.
+// The two expressions should be in comparable forms, e.g. both normalized.
+@interface MTRuleIdentifier : NSObject
+
+// Returns the rule which transforms previous into next, or nil if no single rule does.
+// If the expressions differ only in the order of the terms, MTReorderTermsRule is returned.
+- (MTRuleIdentification*) identifyRuleFrom:(MTExpression*) previous to:(MTExpression*) next;
+
+// Identifies the rule for each consecutive pair of steps. Returns an array with steps.count - 1 entries, each of which is either
+// an MTRuleIdentification or NSNull if no rule was found for that pair. The pairs are processed concurrently.
+- (NSArray*) identifyRulesInDerivation:(NSArray*) steps;
+
+@end
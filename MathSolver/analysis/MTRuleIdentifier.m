@@ -0,0 +1,307 @@
+//
+//  MTRuleIdentifier.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import "MTRuleIdentifier.h"
+#import "MTCalculateRule.h"
+#import "MTNullRule.h"
+#import "MTIdentityRule.h"
+#import "MTZeroRule.h"
+#import "MTDistributionRule.h"
+#import "MTFlattenRule.h"
+#import "MTCollectLikeTermsRule.h"
+#import "MTReduceRule.h"
+#import "MTNestedDivisionRule.h"
+#import "MTDivisionIdentityRule.h"
+#import "MTRationalAdditionRule.h"
+#import "MTRationalMultiplicationRule.h"
+#import "MTCancelCommonFactorsRule.h"
+#import "MTRemoveNegativesRule.h"
+#import "MTReorderTermsRule.h"
+
+#pragma mark - MTRuleIdentification
+
+@implementation MTRuleIdentification
+
++ (instancetype) identificationWithRule:(MTRule*) rule location:(NSIndexPath*) location before:(MTExpression*) before after:(MTExpression*) after
+{
+    MTRuleIdentification* identification = [self new];
+    identification->_rule = rule;
+    identification->_location = location;
+    identification->_before = before;
+    identification->_after = after;
+    return identification;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"%@ at %@: %@ => %@", NSStringFromClass([self.rule class]), self.location, self.before, self.after];
+}
+
+@end
+
+#pragma mark - MTRuleIdentifier
+
+// A pair of corresponding subexpressions found while diffing.
+@interface MTDiffFrame : NSObject
+
+@property (nonatomic) MTExpression* before;
+@property (nonatomic) MTExpression* after;
+@property (nonatomic) NSIndexPath* location;
+// The indices of the children of before which are not present in after.
+@property (nonatomic) NSIndexSet* removed;
+
+@end
+
+@implementation MTDiffFrame
+@end
+
+// A hash which is the same for expressions that are equal upto rearranging the children of their operators, since the
+// hashes of the children are added instead of being combined in order.
+static NSUInteger rearrangementHash(MTExpression* expr) {
+    if (expr.expressionType != kMTExpressionTypeOperator) {
+        return expr.hash;
+    }
+    NSUInteger hash = 0;
+    for (MTExpression* child in expr.children) {
+        NSUInteger childHash = rearrangementHash(child);
+        hash += (childHash ^ (childHash >> 16)) * 31;
+    }
+    return 31 * hash + ((MTOperator*) expr).type;
+}
+
+@implementation MTRuleIdentifier {
+    // The rules that apply to the top level of an operator, keyed by the operator type.
+    NSDictionary* _operatorRules;
+    // The rules that apply to numbers.
+    NSArray* _numberRules;
+    MTReorderTermsRule* _reorder;
+}
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        MTRule* calculate = [MTCalculateRule rule];
+        MTRule* nullRule = [MTNullRule rule];
+        MTRule* identity = [MTIdentityRule rule];
+        MTRule* flatten = [MTFlattenRule rule];
+        MTRule* removeNegatives = [MTRemoveNegativesRule rule];
+        // The dispatch signature of each rule, i.e. the kinds of node for which its applyToTopLevelNode:withChildren: can
+        // return something other than its input. The order is the order in which rules are tried.
+        _operatorRules = @{ @(kMTAddition) : @[flatten, calculate, identity, [MTCollectLikeTermsRule rule], [MTRationalAdditionRule rule], nullRule],
+                            @(kMTMultiplication) : @[flatten, calculate, identity, [MTZeroRule rule], [MTDistributionRule rule], [MTRationalMultiplicationRule rule], nullRule],
+                            @(kMTDivision) : @[calculate, [MTDivisionIdentityRule rule], [MTNestedDivisionRule rule], [MTCancelCommonFactorsRule rule], nullRule],
+                            @(kMTSubtraction) : @[removeNegatives, nullRule],
+                            @(kMTUnaryMinus) : @[removeNegatives, nullRule],
+                            };
+        _numberRules = @[[MTReduceRule rule]];
+        _reorder = [MTReorderTermsRule rule];
+    }
+    return self;
+}
+
+- (NSArray*) rulesForExpression:(MTExpression*) expr
+{
+    switch (expr.expressionType) {
+        case kMTExpressionTypeNumber:
+            return _numberRules;
+
+        case kMTExpressionTypeOperator: {
+            MTOperator* oper = (MTOperator*) expr;
+            NSArray* rules = _operatorRules[@(oper.type)];
+            return (rules) ? rules : @[];
+        }
+
+        case kMTExpressionTypeVariable:
+        case kMTExpressionTypeNull:
+            return @[];
+    }
+    return @[];
+}
+
+// Matches the children of after to equal children of before, preferring the child at the same index. The children of addition
+// and multiplication may also match out of order. Returns the indices of the unmatched children of before and sets added to
+// the unmatched children of after.
+- (NSIndexSet*) removedChildrenOf:(MTOperator*) before comparedTo:(MTOperator*) after added:(NSArray**) added
+{
+    NSArray* beforeChildren = before.children;
+    NSArray* afterChildren = after.children;
+    NSMutableIndexSet* removed = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, beforeChildren.count)];
+    NSMutableIndexSet* unmatched = [NSMutableIndexSet indexSet];
+    for (NSUInteger i = 0; i < afterChildren.count; i++) {
+        if (i < beforeChildren.count && [beforeChildren[i] isEqual:afterChildren[i]]) {
+            [removed removeIndex:i];
+        } else {
+            [unmatched addIndex:i];
+        }
+    }
+    if (before.type == kMTAddition || before.type == kMTMultiplication) {
+        NSMutableIndexSet* matched = [NSMutableIndexSet indexSet];
+        [unmatched enumerateIndexesUsingBlock:^(NSUInteger i, BOOL *stop) {
+            NSUInteger index = [removed indexPassingTest:^BOOL(NSUInteger j, BOOL *stopTest) {
+                return [beforeChildren[j] isEqual:afterChildren[i]];
+            }];
+            if (index != NSNotFound) {
+                [removed removeIndex:index];
+                [matched addIndex:i];
+            }
+        }];
+        [unmatched removeIndexes:matched];
+    }
+    *added = [afterChildren objectsAtIndexes:unmatched];
+    return removed;
+}
+
+// Walks down both trees while exactly one child differs. Returns the frames from the root to the deepest changed subexpression.
+- (NSArray*) diff:(MTExpression*) previous with:(MTExpression*) next
+{
+    NSMutableArray* frames = [NSMutableArray array];
+    MTExpression* before = previous;
+    MTExpression* after = next;
+    NSIndexPath* location = [NSIndexPath new];
+    while (true) {
+        MTDiffFrame* frame = [MTDiffFrame new];
+        frame.before = before;
+        frame.after = after;
+        frame.location = location;
+        frame.removed = [NSIndexSet indexSet];
+        [frames addObject:frame];
+        if (before.expressionType != kMTExpressionTypeOperator || after.expressionType != kMTExpressionTypeOperator
+            || ((MTOperator*) before).type != ((MTOperator*) after).type) {
+            break;
+        }
+        NSArray* added;
+        NSIndexSet* removed = [self removedChildrenOf:(MTOperator*)before comparedTo:(MTOperator*)after added:&added];
+        frame.removed = removed;
+        if (removed.count != 1 || added.count != 1) {
+            break;
+        }
+        // Exactly one child was replaced, so the change is inside it. The index is taken from the match since the same
+        // child may occur more than once.
+        location = [location indexPathByAddingIndex:removed.firstIndex];
+        before = before.children[removed.firstIndex];
+        after = added[0];
+    }
+    return frames;
+}
+
+// If after is a rearrangement of before. The recursive comparison is exponential, so it is only made for operators of the
+// same type and size whose rearrangement hashes match.
+- (BOOL) isRearrangement:(MTExpression*) before of:(MTExpression*) after
+{
+    if ([before isEqualUptoRearrangement:after]) {
+        return YES;
+    }
+    if (before.expressionType != kMTExpressionTypeOperator || after.expressionType != kMTExpressionTypeOperator) {
+        return NO;
+    }
+    MTOperator* beforeOper = (MTOperator*) before;
+    MTOperator* afterOper = (MTOperator*) after;
+    if (beforeOper.type != afterOper.type || beforeOper.size != afterOper.size
+        || rearrangementHash(before) != rearrangementHash(after)) {
+        return NO;
+    }
+    return [before isEqualUptoRearrangementRecursive:after];
+}
+
+// Everything outside the deepest frame of the diff is equal, so only the subexpressions at that frame are compared upto
+// rearrangement.
+- (BOOL) expression:(MTExpression*) expr matches:(MTExpression*) target
+{
+    if ([expr isEqual:target]) {
+        return YES;
+    }
+    MTDiffFrame* deepest = [[self diff:expr with:target] lastObject];
+    return [self isRearrangement:deepest.before of:deepest.after];
+}
+
+// Applies the rule to the top level of the children of oper at the given indices. Returns nil if the rule did not change any of them.
+- (MTExpression*) applyRule:(MTRule*) rule toChildren:(NSIndexSet*) indices of:(MTOperator*) oper
+{
+    if (oper.children.count < 2) {
+        // Unary operators are handled as the top level node.
+        return nil;
+    }
+    BOOL changed = NO;
+    NSMutableArray* args = [NSMutableArray arrayWithArray:oper.children];
+    for (NSUInteger i = indices.firstIndex; i != NSNotFound; i = [indices indexGreaterThanIndex:i]) {
+        MTExpression* child = args[i];
+        MTExpression* applied = [rule applyToTopLevelNode:child withChildren:child.children];
+        changed |= (applied != child);
+        args[i] = applied;
+    }
+    if (!changed) {
+        return nil;
+    }
+    return [MTOperator operatorWithType:oper.type args:args];
+}
+
+- (MTRuleIdentification *)identifyRuleFrom:(MTExpression *)previous to:(MTExpression *)next
+{
+    if ([previous isEqual:next]) {
+        return nil;
+    }
+
+    NSArray* frames = [self diff:previous with:next];
+    // The trees are equal outside the deepest frame, so a rearrangement only needs to be checked there.
+    MTDiffFrame* deepest = frames.lastObject;
+    if ([self isRearrangement:deepest.before of:deepest.after]) {
+        return [MTRuleIdentification identificationWithRule:_reorder location:deepest.location before:deepest.before after:deepest.after];
+    }
+    // Try the deepest change first and move towards the root, since a rule applied to a node may change all of its children.
+    for (MTDiffFrame* frame in frames.reverseObjectEnumerator) {
+        for (MTRule* rule in [self rulesForExpression:frame.before]) {
+            MTExpression* applied = [rule applyToTopLevelNode:frame.before withChildren:frame.before.children];
+            if (applied != frame.before && [self expression:applied matches:frame.after]) {
+                return [MTRuleIdentification identificationWithRule:rule location:frame.location before:frame.before after:frame.after];
+            }
+        }
+        // The same rule may have been applied to several of the removed children at once, e.g. two calculations in one step.
+        NSMutableArray* candidates = [NSMutableArray array];
+        for (MTExpression* child in [frame.before.children objectsAtIndexes:frame.removed]) {
+            for (MTRule* rule in [self rulesForExpression:child]) {
+                if (![candidates containsObject:rule]) {
+                    [candidates addObject:rule];
+                }
+            }
+        }
+        for (MTRule* rule in candidates) {
+            MTExpression* applied = [self applyRule:rule toChildren:frame.removed of:(MTOperator*)frame.before];
+            if (applied && [self expression:applied matches:frame.after]) {
+                return [MTRuleIdentification identificationWithRule:rule location:frame.location before:frame.before after:frame.after];
+            }
+        }
+    }
+    InfoLog(@"No rule found for %@ => %@", previous, next);
+    return nil;
+}
+
+- (NSArray *)identifyRulesInDerivation:(NSArray *)steps
+{
+    if (steps.count < 2) {
+        return @[];
+    }
+    NSUInteger count = steps.count - 1;
+    NSMutableArray* results = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [results addObject:[NSNull null]];
+    }
+    dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        MTRuleIdentification* identification = [self identifyRuleFrom:steps[i] to:steps[i + 1]];
+        if (identification) {
+            @synchronized(results) {
+                results[i] = identification;
+            }
+        }
+    });
+    return results;
+}
+
+@end
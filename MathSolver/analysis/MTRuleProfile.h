@@ -0,0 +1,48 @@
+//
+//  MTRuleProfile.h
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <Foundation/Foundation.h>
+#import "MTExpression.h"
+
+@class MTRule;
+
+// Records how often each rule fires while canonicalizing expressions of a given class and uses it to order the rules,
+// so that the rules which are most likely to apply are tried first. Expressions are classified by whether they contain
+// a division, their degree and their number of terms. Rules are told apart by their identifier. The profile can be exported
+// and loaded again. This class is thread safe.
+@interface MTRuleProfile : NSObject
+
+// Loads a profile previously returned by dataRepresentation. Returns nil if the data is not a valid profile.
++ (instancetype) profileWithData:(NSData*) data;
+
+// The class of the expression used as the key for the rule order, e.g. "d2 t3" for a polynomial of degree 2 with 3 terms
+// or "r t2" for a sum of 2 terms containing a division.
++ (NSString*) classOfExpression:(MTExpression*) expr;
+
+// If the profile records the rules which fire. Defaults to YES. A loaded profile can be frozen by setting this to NO.
+@property (nonatomic) BOOL recording;
+
+// The total number of fixpoint passes made by the canonicalizers using this profile. This is counted even when not recording.
+@property (nonatomic, readonly) NSUInteger passes;
+
+// Returns the rules (MTRule) sorted so that the rules which fired most often for the key come first. Rules which have not fired
+// for the key keep their relative order at the end.
+- (NSArray*) orderRules:(NSArray*) rules forKey:(NSString*) key;
+
+// Records that the rule changed an expression with the given key.
+- (void) recordRule:(MTRule*) rule firedForKey:(NSString*) key;
+
+// Records the number of passes made to reach a fixpoint.
+- (void) recordPasses:(NSUInteger) passes;
+
+// A JSON representation of the counts, which can be loaded using profileWithData:.
+- (NSData*) dataRepresentation;
+
+@end
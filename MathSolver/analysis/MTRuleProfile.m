@@ -0,0 +1,222 @@
+//
+//  MTRuleProfile.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import "MTRuleProfile.h"
+#import "MTRule.h"
+
+// Degrees and term counts above these are put in the same class.
+static const NSUInteger kMTRuleProfileMaxDegree = 3;
+static const NSUInteger kMTRuleProfileMaxTerms = 8;
+
+static NSString* const kMTRuleProfileCountsKey = @"counts";
+static NSString* const kMTRuleProfilePassesKey = @"passes";
+
+// The degree of a polynomial, ignoring any divisions which are reported in hasDivision.
+static NSUInteger polynomialDegree(MTExpression* expr, BOOL* hasDivision) {
+    switch (expr.expressionType) {
+        case kMTExpressionTypeNumber:
+        case kMTExpressionTypeNull:
+            return 0;
+
+        case kMTExpressionTypeVariable:
+            return 1;
+
+        case kMTExpressionTypeOperator:
+            break;
+    }
+    MTOperator* oper = (MTOperator*) expr;
+    if (oper.type == kMTDivision) {
+        *hasDivision = YES;
+    }
+    NSUInteger degree = 0;
+    for (MTExpression* child in oper.children) {
+        NSUInteger childDegree = polynomialDegree(child, hasDivision);
+        if (oper.type == kMTMultiplication) {
+            degree += childDegree;
+        } else {
+            degree = MAX(degree, childDegree);
+        }
+    }
+    return degree;
+}
+
+// The rules in the order last computed for a key.
+@interface MTRuleOrder : NSObject
+
+// The rules as given to orderRules:forKey:.
+@property (nonatomic) NSArray* rules;
+@property (nonatomic) NSArray* sortedRules;
+
+@end
+
+@implementation MTRuleOrder
+@end
+
+@implementation MTRuleProfile {
+    // key -> (rule identifier -> count)
+    NSMutableDictionary* _counts;
+    // key -> MTRuleOrder, removed when a count changes the order.
+    NSMutableDictionary* _orders;
+    NSUInteger _passes;
+    BOOL _recording;
+}
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        _counts = [NSMutableDictionary dictionary];
+        _orders = [NSMutableDictionary dictionary];
+        _recording = YES;
+    }
+    return self;
+}
+
++ (instancetype) profileWithData:(NSData*) data
+{
+    NSError* error = nil;
+    NSDictionary* dict = [NSJSONSerialization JSONObjectWithData:data options:0 error:&error];
+    if (![dict isKindOfClass:[NSDictionary class]]) {
+        InfoLog(@"Unable to load rule profile: %@", error);
+        return nil;
+    }
+    NSDictionary* counts = dict[kMTRuleProfileCountsKey];
+    NSNumber* passes = dict[kMTRuleProfilePassesKey];
+    if (![counts isKindOfClass:[NSDictionary class]] || ![passes isKindOfClass:[NSNumber class]]) {
+        InfoLog(@"Invalid rule profile: %@", dict);
+        return nil;
+    }
+    MTRuleProfile* profile = [self new];
+    for (NSString* key in counts) {
+        NSDictionary* ruleCounts = counts[key];
+        if (![ruleCounts isKindOfClass:[NSDictionary class]]) {
+            InfoLog(@"Invalid rule counts for %@: %@", key, ruleCounts);
+            return nil;
+        }
+        profile->_counts[key] = [ruleCounts mutableCopy];
+    }
+    profile->_passes = passes.unsignedIntegerValue;
+    return profile;
+}
+
++ (NSString*) classOfExpression:(MTExpression*) expr
+{
+    BOOL hasDivision = NO;
+    NSUInteger degree = MIN(polynomialDegree(expr, &hasDivision), kMTRuleProfileMaxDegree);
+    NSUInteger terms = 1;
+    if (expr.expressionType == kMTExpressionTypeOperator && ((MTOperator*) expr).type == kMTAddition) {
+        terms = MIN(expr.children.count, kMTRuleProfileMaxTerms);
+    }
+    if (hasDivision) {
+        return [NSString stringWithFormat:@"r t%lu", (unsigned long) terms];
+    }
+    return [NSString stringWithFormat:@"d%lu t%lu", (unsigned long) degree, (unsigned long) terms];
+}
+
+- (NSUInteger) passes
+{
+    @synchronized(self) {
+        return _passes;
+    }
+}
+
+- (BOOL) recording
+{
+    @synchronized(self) {
+        return _recording;
+    }
+}
+
+- (void) setRecording:(BOOL) recording
+{
+    @synchronized(self) {
+        _recording = recording;
+    }
+}
+
+- (NSArray*) orderRules:(NSArray*) rules forKey:(NSString*) key
+{
+    NSDictionary* ruleCounts;
+    @synchronized(self) {
+        MTRuleOrder* order = _orders[key];
+        if (order && [order.rules isEqualToArray:rules]) {
+            return order.sortedRules;
+        }
+        ruleCounts = [_counts[key] copy];
+    }
+    if (!ruleCounts.count) {
+        return rules;
+    }
+    // The sort is stable so rules with the same count keep their order.
+    NSArray* sortedRules = [rules sortedArrayWithOptions:NSSortStable usingComparator:^NSComparisonResult(MTRule* rule1, MTRule* rule2) {
+        NSUInteger count1 = [ruleCounts[rule1.identifier] unsignedIntegerValue];
+        NSUInteger count2 = [ruleCounts[rule2.identifier] unsignedIntegerValue];
+        if (count1 > count2) {
+            return NSOrderedAscending;
+        } else if (count1 < count2) {
+            return NSOrderedDescending;
+        }
+        return NSOrderedSame;
+    }];
+    MTRuleOrder* order = [MTRuleOrder new];
+    order.rules = [rules copy];
+    order.sortedRules = sortedRules;
+    @synchronized(self) {
+        _orders[key] = order;
+    }
+    return sortedRules;
+}
+
+- (void) recordRule:(MTRule*) rule firedForKey:(NSString*) key
+{
+    NSString* ruleName = rule.identifier;
+    @synchronized(self) {
+        if (!_recording) {
+            return;
+        }
+        NSMutableDictionary* ruleCounts = _counts[key];
+        if (!ruleCounts) {
+            ruleCounts = [NSMutableDictionary dictionary];
+            _counts[key] = ruleCounts;
+        }
+        NSUInteger count = [ruleCounts[ruleName] unsignedIntegerValue] + 1;
+        ruleCounts[ruleName] = @(count);
+        // Most counts do not change the order. A rule can only move ahead of the rule before it, and only once its count
+        // reaches that rule's count.
+        NSArray* sortedRules = [_orders[key] sortedRules];
+        if (sortedRules) {
+            NSUInteger index = [sortedRules indexOfObject:rule];
+            if (index == NSNotFound || (index > 0 && count >= [ruleCounts[[sortedRules[index - 1] identifier]] unsignedIntegerValue])) {
+                [_orders removeObjectForKey:key];
+            }
+        }
+    }
+}
+
+- (void) recordPasses:(NSUInteger) passes
+{
+    @synchronized(self) {
+        _passes += passes;
+    }
+}
+
+- (NSData*) dataRepresentation
+{
+    NSDictionary* dict;
+    @synchronized(self) {
+        dict = @{ kMTRuleProfileCountsKey : _counts, kMTRuleProfilePassesKey : @(_passes) };
+        NSError* error = nil;
+        NSData* data = [NSJSONSerialization dataWithJSONObject:dict options:0 error:&error];
+        NSAssert(data, @"Unable to serialize the rule profile: %@", error);
+        return data;
+    }
+}
+
+@end
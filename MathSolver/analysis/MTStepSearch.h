@@ -0,0 +1,70 @@
+//
+//  MTStepSearch.h
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <Foundation/Foundation.h>
+#import "MTExpression.h"
+
+@class MTRule;
+
+// A single step of a derivation: the rule that was applied and the expression it produced.
+@interface MTStep : NSObject
+
++ (instancetype) stepWithRule:(MTRule*) rule expression:(MTExpression*) expression;
+
+@property (nonatomic, readonly) MTRule* rule;
+@property (nonatomic, readonly) MTExpression* expression;
+
+@end
+
+// The outcome of a search by MTStepSearch.
+@interface MTStepSearchResult : NSObject
+
+// True if the last step (or the start expression if there are no steps) is in normal form.
+@property (nonatomic, readonly) BOOL reachedNormalForm;
+// The steps from the normalized start expression to the normal form. If the normal form was not reached within the budget
+// these are the steps to the simplest expression found.
+@property (nonatomic, readonly) NSArray* steps;
+// The number of expressions expanded by the search.
+@property (nonatomic, readonly) NSUInteger nodesExpanded;
+
+@end
+
+// Best first search over single rule applications (see MTRule applyInnerMost:onlyFirst:) from an expression to its normal form.
+// Every expression seen is kept in a transposition table so that different orders of applying the same rules are only expanded once.
+// The search is used to generate hints and to check whether a step taken by a student can lead to the normal form.
+// The rules are applied in the same phases as MTExpressionCanonicalizer: first the division rules until the expression is in rational
+// form, then the polynomial rules to the numerator and the denominator separately, and finally the numerator and denominator are
+// divided by the leading coefficient of the denominator. An expression to which no rule applies and which is not the normal form
+// is a dead end.
+@interface MTStepSearch : NSObject
+
+// A search using the rules of the canonicalizer.
+- (id) init;
+
+// A search applying the division rules (MTRule) and then the polynomial rules (MTRule).
+- (instancetype) initWithDivisionRules:(NSArray*) divisionRules polynomialRules:(NSArray*) polynomialRules;
+
+// Maximum number of steps from the start. Defaults to 20.
+@property (nonatomic) NSUInteger maxDepth;
+// Maximum number of expressions expanded. Defaults to 2000.
+@property (nonatomic) NSUInteger maxNodes;
+// Maximum time in seconds spent on a single search. Defaults to 0.25.
+@property (nonatomic) NSTimeInterval timeLimit;
+// If true, rule applications on independent frontier expressions are computed concurrently. Defaults to YES.
+// The result does not depend on this setting unless the time limit is hit.
+@property (nonatomic) BOOL parallel;
+
+// Search for a derivation of the normal form of the expression. The expression is normalized before searching.
+- (MTStepSearchResult*) searchFromExpression:(MTExpression*) expr;
+
+// Returns the first step towards the normal form. Returns nil if the expression is already in normal form or no step was found.
+- (MTStep*) nextStepForExpression:(MTExpression*) expr;
+
+@end
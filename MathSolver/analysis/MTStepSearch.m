@@ -0,0 +1,382 @@
+//
+//  MTStepSearch.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import "MTStepSearch.h"
+#import "MTCanonicalizer.h"
+#import "MTExpressionUtil.h"
+#import "MTCalculateRule.h"
+#import "MTNullRule.h"
+#import "MTIdentityRule.h"
+#import "MTZeroRule.h"
+#import "MTDistributionRule.h"
+#import "MTFlattenRule.h"
+#import "MTCollectLikeTermsRule.h"
+#import "MTReduceRule.h"
+#import "MTNestedDivisionRule.h"
+#import "MTRationalAdditionRule.h"
+#import "MTRationalMultiplicationRule.h"
+#import "MTCancelCommonFactorsRule.h"
+#import "MTReorderTermsRule.h"
+
+// The number of frontier expressions expanded together.
+static const NSUInteger kMTStepSearchBatchSize = 8;
+
+// The phases of the canonicalizer. The division rules are applied until the expression is in rational form, then the polynomial
+// rules are applied to the numerator and denominator separately.
+typedef enum {
+    kMTStepSearchPhaseDivision = 0,
+    kMTStepSearchPhasePolynomial,
+} MTStepSearchPhase;
+
+#pragma mark - MTScaleDenominatorRule
+
+// Divides the numerator and the denominator of a rational expression by the leading coefficient of the denominator. This is the
+// last step of the canonicalizer for rational expressions, so it is only applied to the top level node once no other rule applies.
+@interface MTScaleDenominatorRule : MTRule
+
+@end
+
+@implementation MTScaleDenominatorRule {
+    MTReorderTermsRule* _reorder;
+}
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        _reorder = [MTReorderTermsRule rule];
+    }
+    return self;
+}
+
+- (MTExpression*) applyToTopLevelNode:(MTExpression *)expr withChildren:(NSArray *)args
+{
+    if (![MTExpressionUtil isDivision:expr]) {
+        return expr;
+    }
+    MTExpression* denominator = [_reorder apply:args[1]];
+    if (denominator.expressionType == kMTExpressionTypeOperator && denominator.opcode != kMTOpcodeAddition && denominator.opcode != kMTOpcodeMultiplication) {
+        // not a polynomial
+        return expr;
+    }
+    MTRational* coefficient;
+    NSArray* variables;
+    if (![MTExpressionUtil expression:[MTExpressionUtil getLeadingTerm:denominator] getCoefficent:&coefficient variables:&variables]
+        || [coefficient isEquivalent:[MTRational one]]) {
+        return expr;
+    }
+    MTNumber* divisor = [MTNumber numberWithValue:coefficient];
+    return [MTOperator operatorWithType:kMTDivision args:[MTOperator operatorWithType:kMTDivision args:args[0] :divisor]
+                                                        :[MTOperator operatorWithType:kMTDivision args:args[1] :divisor]];
+}
+
+@end
+
+#pragma mark - MTStep
+
+@implementation MTStep
+
++ (instancetype)stepWithRule:(MTRule *)rule expression:(MTExpression *)expression
+{
+    MTStep* step = [self new];
+    step->_rule = rule;
+    step->_expression = expression;
+    return step;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"%@: %@", NSStringFromClass([self.rule class]), self.expression];
+}
+
+@end
+
+#pragma mark - MTStepSearchResult
+
+@implementation MTStepSearchResult
+
++ (instancetype) resultWithSteps:(NSArray*) steps reachedNormalForm:(BOOL) reachedNormalForm nodesExpanded:(NSUInteger) nodesExpanded
+{
+    MTStepSearchResult* result = [self new];
+    result->_steps = steps;
+    result->_reachedNormalForm = reachedNormalForm;
+    result->_nodesExpanded = nodesExpanded;
+    return result;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"Reached normal form:%d Nodes expanded:%lu Steps:%@", self.reachedNormalForm, (unsigned long)self.nodesExpanded, self.steps];
+}
+
+@end
+
+#pragma mark - MTStepSearchNode
+
+// A node in the search tree.
+@interface MTStepSearchNode : NSObject
+
+@property (nonatomic, readonly) MTExpression* expression;
+@property (nonatomic, readonly) MTRule* rule;
+@property (nonatomic, readonly) MTStepSearchNode* parent;
+@property (nonatomic, readonly) NSUInteger depth;
+@property (nonatomic, readonly) NSUInteger size;
+@property (nonatomic, readonly) MTStepSearchPhase phase;
+
+@end
+
+@implementation MTStepSearchNode
+
++ (instancetype) nodeWithExpression:(MTExpression*) expression rule:(MTRule*) rule parent:(MTStepSearchNode*) parent phase:(MTStepSearchPhase) phase
+{
+    MTStepSearchNode* node = [self new];
+    node->_expression = expression;
+    node->_rule = rule;
+    node->_parent = parent;
+    node->_phase = phase;
+    node->_depth = (parent) ? parent.depth + 1 : 0;
+    node->_size = [MTExpressionUtil sizeOfExpression:expression];
+    return node;
+}
+
+- (NSUInteger) cost
+{
+    return _depth + _size;
+}
+
+- (NSArray*) steps
+{
+    NSMutableArray* steps = [NSMutableArray arrayWithCapacity:_depth];
+    for (MTStepSearchNode* node = self; node.parent; node = node.parent) {
+        [steps insertObject:[MTStep stepWithRule:node.rule expression:node.expression] atIndex:0];
+    }
+    return steps;
+}
+
+@end
+
+#pragma mark - MTStepSearch
+
+@implementation MTStepSearch {
+    NSArray* _divisionRules;
+    NSArray* _polynomialRules;
+    MTScaleDenominatorRule* _scaleDenominator;
+    MTReorderTermsRule* _reorder;
+}
+
+- (id) init
+{
+    // The rules used by the canonicalizer. Reordering is not a step, it is applied before comparing with the normal form.
+    NSArray* divisionRules = @[[MTCalculateRule rule],
+                               [MTNullRule rule],
+                               [MTIdentityRule rule],
+                               [MTZeroRule rule],
+                               [MTFlattenRule rule],
+                               [MTNestedDivisionRule rule],
+                               [MTCollectLikeTermsRule rule],
+                               [MTReduceRule rule],
+                               [MTRationalAdditionRule rule],
+                               [MTRationalMultiplicationRule rule],
+                               [MTCancelCommonFactorsRule rule]];
+    NSArray* polynomialRules = @[[MTCalculateRule rule],
+                                 [MTNullRule rule],
+                                 [MTIdentityRule rule],
+                                 [MTZeroRule rule],
+                                 [MTDistributionRule rule],
+                                 [MTFlattenRule rule],
+                                 [MTCollectLikeTermsRule rule],
+                                 [MTReduceRule rule]];
+    return [self initWithDivisionRules:divisionRules polynomialRules:polynomialRules];
+}
+
+- (instancetype) initWithDivisionRules:(NSArray*) divisionRules polynomialRules:(NSArray*) polynomialRules
+{
+    self = [super init];
+    if (self) {
+        _maxDepth = 20;
+        _maxNodes = 2000;
+        _timeLimit = 0.25;
+        _parallel = YES;
+        _reorder = [MTReorderTermsRule rule];
+        _scaleDenominator = [MTScaleDenominatorRule rule];
+        _divisionRules = divisionRules;
+        _polynomialRules = polynomialRules;
+    }
+    return self;
+}
+
+- (MTStep *)nextStepForExpression:(MTExpression *)expr
+{
+    MTStepSearchResult* result = [self searchFromExpression:expr];
+    if (result.reachedNormalForm && result.steps.count > 0) {
+        return result.steps[0];
+    }
+    return nil;
+}
+
+- (BOOL) isExpression:(MTExpression*) expr normalForm:(MTExpression*) normalForm
+{
+    return [[_reorder apply:expr] isEqual:normalForm];
+}
+
+- (NSArray*) rulesForPhase:(MTStepSearchPhase) phase
+{
+    return (phase == kMTStepSearchPhaseDivision) ? _divisionRules : _polynomialRules;
+}
+
+- (MTStepSearchResult *)searchFromExpression:(MTExpression *)expr
+{
+    NSTimeInterval deadline = [NSDate timeIntervalSinceReferenceDate] + self.timeLimit;
+    MTExpressionCanonicalizer* canonicalizer = [MTCanonicalizerFactory getExpressionCanonicalizer];
+    MTExpression* start = [canonicalizer normalize:expr];
+    MTExpression* normalForm = [canonicalizer normalForm:start];
+
+    MTStepSearchNode* root = [MTStepSearchNode nodeWithExpression:start rule:nil parent:nil phase:kMTStepSearchPhaseDivision];
+    if ([self isExpression:start normalForm:normalForm]) {
+        return [MTStepSearchResult resultWithSteps:@[] reachedNormalForm:YES nodesExpanded:0];
+    }
+
+    // The transposition table of each phase maps each expression seen to the shallowest node that reached it.
+    NSArray* transpositions = @[[NSMapTable strongToStrongObjectsMapTable], [NSMapTable strongToStrongObjectsMapTable]];
+    [transpositions[root.phase] setObject:root forKey:start];
+    // Open nodes sorted by cost, ties are broken by the order of insertion.
+    NSMutableArray* open = [NSMutableArray arrayWithObject:root];
+    NSComparator byCost = ^NSComparisonResult(MTStepSearchNode* n1, MTStepSearchNode* n2) {
+        if (n1.cost < n2.cost) {
+            return NSOrderedAscending;
+        } else if (n1.cost > n2.cost) {
+            return NSOrderedDescending;
+        }
+        return NSOrderedSame;
+    };
+
+    MTStepSearchNode* best = root;
+    NSUInteger expanded = 0;
+    while (open.count > 0 && expanded < self.maxNodes && [NSDate timeIntervalSinceReferenceDate] < deadline) {
+        NSUInteger batchSize = MIN(MIN(kMTStepSearchBatchSize, open.count), self.maxNodes - expanded);
+        NSArray* batch = [open subarrayWithRange:NSMakeRange(0, batchSize)];
+        [open removeObjectsInRange:NSMakeRange(0, batchSize)];
+        expanded += batchSize;
+
+        NSArray* successors = [self expand:batch];
+        for (NSUInteger i = 0; i < batch.count; i++) {
+            MTStepSearchNode* node = batch[i];
+            NSArray* rules = [self rulesForPhase:node.phase];
+            NSMutableArray* children = [NSMutableArray arrayWithCapacity:rules.count];
+            for (NSUInteger j = 0; j < rules.count; j++) {
+                MTExpression* next = successors[i][j];
+                if (next == node.expression || [next isEqual:node.expression]) {
+                    // the rule does not apply
+                    continue;
+                }
+                [children addObject:[MTStepSearchNode nodeWithExpression:next rule:rules[j] parent:node phase:node.phase]];
+            }
+            if (children.count == 0) {
+                if (node.phase == kMTStepSearchPhaseDivision) {
+                    // The expression is in rational form, continue with the polynomial rules from the same node.
+                    [children addObject:[MTStepSearchNode nodeWithExpression:node.expression rule:node.rule parent:node.parent phase:kMTStepSearchPhasePolynomial]];
+                } else {
+                    MTExpression* scaled = [_scaleDenominator applyToTopLevelNode:node.expression withChildren:node.expression.children];
+                    if (scaled != node.expression) {
+                        [children addObject:[MTStepSearchNode nodeWithExpression:scaled rule:_scaleDenominator parent:node phase:kMTStepSearchPhasePolynomial]];
+                    }
+                    // Otherwise no rule applies and the expression is not the normal form, so this is a dead end.
+                }
+            }
+            for (MTStepSearchNode* child in children) {
+                if ([self isExpression:child.expression normalForm:normalForm]) {
+                    return [MTStepSearchResult resultWithSteps:child.steps reachedNormalForm:YES nodesExpanded:expanded];
+                }
+                NSMapTable* table = transpositions[child.phase];
+                MTStepSearchNode* seen = [table objectForKey:child.expression];
+                if (seen && seen.depth <= child.depth) {
+                    continue;
+                }
+                [table setObject:child forKey:child.expression];
+                if (child.size < best.size) {
+                    best = child;
+                }
+                if (child.depth < self.maxDepth) {
+                    NSUInteger index = [open indexOfObject:child inSortedRange:NSMakeRange(0, open.count) options:NSBinarySearchingInsertionIndex | NSBinarySearchingLastEqual usingComparator:byCost];
+                    [open insertObject:child atIndex:index];
+                }
+            }
+        }
+    }
+    InfoLog(@"Normal form of %@ not found after expanding %lu expressions", expr, (unsigned long)expanded);
+    return [MTStepSearchResult resultWithSteps:best.steps reachedNormalForm:NO nodesExpanded:expanded];
+}
+
+// Applies one step of the rule to the node. Like the canonicalizer, the polynomial rules are applied to the numerator and the
+// denominator of a rational expression separately.
+- (MTExpression*) applyRule:(MTRule*) rule toNode:(MTStepSearchNode*) node
+{
+    MTExpression* expr = node.expression;
+    if (node.phase == kMTStepSearchPhaseDivision || ![MTExpressionUtil isDivision:expr]) {
+        return [rule applyInnerMost:expr onlyFirst:YES];
+    }
+    MTExpression* numerator = expr.children[0];
+    MTExpression* denominator = expr.children[1];
+    MTExpression* next = [rule applyInnerMost:numerator onlyFirst:YES];
+    if (next != numerator && ![next isEqual:numerator]) {
+        return [MTOperator operatorWithType:kMTDivision args:next :denominator];
+    }
+    next = [rule applyInnerMost:denominator onlyFirst:YES];
+    if (next != denominator && ![next isEqual:denominator]) {
+        return [MTOperator operatorWithType:kMTDivision args:numerator :next];
+    }
+    return expr;
+}
+
+// Applies every rule of its phase once to every node in the batch. The result for node i and rule j is at [i][j].
+- (NSArray*) expand:(NSArray*) batch
+{
+    NSMutableArray* successors = [NSMutableArray arrayWithCapacity:batch.count];
+    NSUInteger count = 0;
+    for (MTStepSearchNode* node in batch) {
+        NSUInteger numRules = [self rulesForPhase:node.phase].count;
+        NSMutableArray* results = [NSMutableArray arrayWithCapacity:numRules];
+        for (NSUInteger j = 0; j < numRules; j++) {
+            [results addObject:[NSNull null]];
+        }
+        [successors addObject:results];
+        count += numRules;
+    }
+    // The node and rule for each application.
+    NSUInteger* nodeIndex = malloc(count * sizeof(NSUInteger));
+    NSUInteger* ruleIndex = malloc(count * sizeof(NSUInteger));
+    NSUInteger application = 0;
+    for (NSUInteger i = 0; i < batch.count; i++) {
+        for (NSUInteger j = 0; j < [successors[i] count]; j++, application++) {
+            nodeIndex[application] = i;
+            ruleIndex[application] = j;
+        }
+    }
+    void (^applyRule)(size_t) = ^(size_t k) {
+        MTStepSearchNode* node = batch[nodeIndex[k]];
+        MTRule* rule = [self rulesForPhase:node.phase][ruleIndex[k]];
+        MTExpression* next = [self applyRule:rule toNode:node];
+        @synchronized(successors) {
+            successors[nodeIndex[k]][ruleIndex[k]] = next;
+        }
+    };
+    if (self.parallel && count > 1) {
+        dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), applyRule);
+    } else {
+        for (size_t k = 0; k < count; k++) {
+            applyRule(k);
+        }
+    }
+    free(nodeIndex);
+    free(ruleIndex);
+    return successors;
+}
+
+@end
@@ -0,0 +1,93 @@
+//
+//  MTTrace.h
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <Foundation/Foundation.h>
+#import "MTExpression.h"
+
+// The stages of analysing an input that are timed.
+typedef enum {
+    // MTInfixParser parseFromString: or parseFromMathList:expectedEntityType:
+    kMTTraceStageParse = 0,
+    // The normalized expression of MTExpressionInfo
+    kMTTraceStageNormalize,
+    // The normal form of MTExpressionInfo
+    kMTTraceStageNormalForm,
+    // MTExpressionAnalysis hasCheckableAnswer:, including the normal form if it was not computed before.
+    kMTTraceStageAnalysis,
+    kMTTraceStageCount
+} MTTraceStage;
+
+// An input and the time taken by each stage for it.
+@interface MTTraceRecord : NSObject
+
+// The string given to the parser, or the LaTeX for a math list.
+@property (nonatomic, readonly) NSString* input;
+// If the input is LaTeX for a math list.
+@property (nonatomic, readonly) BOOL isMathList;
+// The entity type the parser was asked for, kMTTypeAny for strings.
+@property (nonatomic, readonly) MTMathEntityType entityType;
+
+// The time in seconds taken by the stage, or a negative number if the stage was not run for this input.
+- (NSTimeInterval) durationForStage:(MTTraceStage) stage;
+// The total time of all stages that were run.
+- (NSTimeInterval) totalDuration;
+
+@end
+
+// A list of trace records which can be saved, loaded, summarized and replayed.
+@interface MTTrace : NSObject
+
+// Loads a trace previously returned by dataRepresentation. Returns nil if the data is not a trace.
++ (instancetype) traceWithData:(NSData*) data;
+
+// Runs each input of the trace through the parser, MTExpressionInfo and MTExpressionAnalysis of the current build
+// and returns a trace with the new timings. Stop the shared recorder before replaying.
++ (MTTrace*) replayTrace:(MTTrace*) trace;
+
+@property (nonatomic, readonly) NSArray* records;
+
+// A compact text representation with one line per record.
+- (NSData*) dataRepresentation;
+
+// The duration below which the given fraction (0 to 1) of the records that ran the stage fall. Returns 0 if no record ran the stage.
+- (NSTimeInterval) percentile:(double) fraction forStage:(MTTraceStage) stage;
+
+// The 50th, 90th and 99th percentiles and the maximum of each stage in milliseconds.
+- (NSString*) report;
+
+// Returns the records of this trace whose total duration is more than factor times that of the record for the same input
+// in the baseline trace and is at least minimumDifference seconds more.
+- (NSArray*) regressionsFromBaseline:(MTTrace*) baseline factor:(double) factor minimumDifference:(NSTimeInterval) minimumDifference;
+
+@end
+
+// Records the inputs to the parser and the time taken by each stage of analysing them. Recording is off unless a shared
+// recorder is set, and stages for entities which did not come from the parser are ignored. This class is thread safe.
+@interface MTTraceRecorder : NSObject
+
+// The recorder used by the parser and analysis. nil by default. A recorder is released once it is replaced and no
+// parse or analysis in progress is still using it.
++ (MTTraceRecorder*) sharedRecorder;
++ (void) setSharedRecorder:(MTTraceRecorder*) recorder;
+
+// Keeps the given number of most recent records. The default initializer keeps 10000.
+- (instancetype) initWithCapacity:(NSUInteger) capacity;
+
+// The records kept, oldest first.
+- (MTTrace*) trace;
+
+// Records a parse. The other stages are recorded against the entity returned by the parser, which may be nil on error.
+- (void) recordParseOfInput:(NSString*) input isMathList:(BOOL) isMathList entityType:(MTMathEntityType) entityType
+                     result:(id<MTMathEntity>) entity duration:(NSTimeInterval) duration;
+
+// Records the time taken by a stage after parsing for an entity returned by the parser.
+- (void) recordStage:(MTTraceStage) stage forEntity:(id<MTMathEntity>) entity duration:(NSTimeInterval) duration;
+
+@end
@@ -0,0 +1,363 @@
+//
+//  MTTrace.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <stdatomic.h>
+
+#import "MTTrace.h"
+#import "MTInfixParser.h"
+#import "MTMathListBuilder.h"
+#import "MTExpressionInfo.h"
+#import "MTExpressionAnalysis.h"
+
+static NSString* const kMTTraceHeader = @"MTTrace 1";
+static NSString* const kMTTraceNotRun = @"-";
+
+static NSString* stageName(MTTraceStage stage) {
+    switch (stage) {
+        case kMTTraceStageParse:
+            return @"parse";
+        case kMTTraceStageNormalize:
+            return @"normalize";
+        case kMTTraceStageNormalForm:
+            return @"normalForm";
+        case kMTTraceStageAnalysis:
+            return @"analysis";
+        case kMTTraceStageCount:
+            break;
+    }
+    NSCAssert(false, @"Unknown stage %d", stage);
+    return nil;
+}
+
+#pragma mark - MTTraceRecord
+
+@interface MTTraceRecord ()
+
++ (instancetype) recordWithInput:(NSString*) input isMathList:(BOOL) isMathList entityType:(MTMathEntityType) entityType;
+- (void) setDuration:(NSTimeInterval) duration forStage:(MTTraceStage) stage;
+- (NSString*) key;
+
+@end
+
+@implementation MTTraceRecord {
+    NSTimeInterval _durations[kMTTraceStageCount];
+}
+
++ (instancetype) recordWithInput:(NSString*) input isMathList:(BOOL) isMathList entityType:(MTMathEntityType) entityType
+{
+    MTTraceRecord* record = [self new];
+    record->_input = input;
+    record->_isMathList = isMathList;
+    record->_entityType = entityType;
+    for (int i = 0; i < kMTTraceStageCount; i++) {
+        record->_durations[i] = -1;
+    }
+    return record;
+}
+
+- (NSTimeInterval)durationForStage:(MTTraceStage)stage
+{
+    return _durations[stage];
+}
+
+- (void) setDuration:(NSTimeInterval) duration forStage:(MTTraceStage) stage
+{
+    _durations[stage] = duration;
+}
+
+- (NSTimeInterval)totalDuration
+{
+    NSTimeInterval total = 0;
+    for (int i = 0; i < kMTTraceStageCount; i++) {
+        if (_durations[i] >= 0) {
+            total += _durations[i];
+        }
+    }
+    return total;
+}
+
+// Identifies the input across traces.
+- (NSString*) key
+{
+    return [NSString stringWithFormat:@"%c%d %@", (_isMathList ? 'L' : 'S'), _entityType, _input];
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"%@ (%.3f ms)", _input, self.totalDuration * 1000];
+}
+
+@end
+
+#pragma mark - MTTrace
+
+@implementation MTTrace
+
++ (instancetype) traceWithRecords:(NSArray*) records
+{
+    MTTrace* trace = [self new];
+    trace->_records = [records copy];
+    return trace;
+}
+
+// Each line is: L or S, entity type, the duration of each stage in microseconds or - and the input.
+- (NSData *)dataRepresentation
+{
+    NSMutableString* str = [NSMutableString stringWithString:kMTTraceHeader];
+    [str appendString:@"\n"];
+    for (MTTraceRecord* record in self.records) {
+        [str appendFormat:@"%c\t%d", (record.isMathList ? 'L' : 'S'), record.entityType];
+        for (int i = 0; i < kMTTraceStageCount; i++) {
+            NSTimeInterval duration = [record durationForStage:i];
+            if (duration < 0) {
+                [str appendFormat:@"\t%@", kMTTraceNotRun];
+            } else {
+                [str appendFormat:@"\t%lld", (long long) llround(duration * 1e6)];
+            }
+        }
+        [str appendFormat:@"\t%@\n", record.input];
+    }
+    return [str dataUsingEncoding:NSUTF8StringEncoding];
+}
+
++ (instancetype)traceWithData:(NSData *)data
+{
+    NSString* str = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    NSArray* lines = [str componentsSeparatedByString:@"\n"];
+    if (lines.count == 0 || ![lines[0] isEqualToString:kMTTraceHeader]) {
+        InfoLog(@"Not a trace file");
+        return nil;
+    }
+    NSMutableArray* records = [NSMutableArray arrayWithCapacity:lines.count - 1];
+    for (NSUInteger i = 1; i < lines.count; i++) {
+        NSString* line = lines[i];
+        if (line.length == 0) {
+            continue;
+        }
+        NSArray* fields = [line componentsSeparatedByString:@"\t"];
+        if (fields.count != kMTTraceStageCount + 3 || [fields[0] length] != 1) {
+            InfoLog(@"Invalid trace line %lu: %@", (unsigned long) i, line);
+            return nil;
+        }
+        BOOL isMathList = [fields[0] isEqualToString:@"L"];
+        MTTraceRecord* record = [MTTraceRecord recordWithInput:fields.lastObject isMathList:isMathList entityType:[fields[1] intValue]];
+        for (int stage = 0; stage < kMTTraceStageCount; stage++) {
+            NSString* field = fields[stage + 2];
+            if (![field isEqualToString:kMTTraceNotRun]) {
+                [record setDuration:field.longLongValue / 1e6 forStage:stage];
+            }
+        }
+        [records addObject:record];
+    }
+    return [self traceWithRecords:records];
+}
+
++ (MTTrace *)replayTrace:(MTTrace *)trace
+{
+    NSMutableArray* records = [NSMutableArray arrayWithCapacity:trace.records.count];
+    for (MTTraceRecord* original in trace.records) {
+        MTTraceRecord* record = [MTTraceRecord recordWithInput:original.input isMathList:original.isMathList entityType:original.entityType];
+        [records addObject:record];
+
+        MTInfixParser* parser = [MTInfixParser new];
+        id<MTMathEntity> entity;
+        CFAbsoluteTime start;
+        if (original.isMathList) {
+            // Building the math list is not part of the parse stage.
+            MTMathList* mathList = [MTMathListBuilder buildFromString:original.input];
+            start = CFAbsoluteTimeGetCurrent();
+            entity = [parser parseFromMathList:mathList expectedEntityType:original.entityType];
+        } else {
+            start = CFAbsoluteTimeGetCurrent();
+            entity = [parser parseFromString:original.input];
+        }
+        [record setDuration:CFAbsoluteTimeGetCurrent() - start forStage:kMTTraceStageParse];
+        if (!entity) {
+            continue;
+        }
+
+        MTExpressionInfo* info = [[MTExpressionInfo alloc] initWithExpression:entity input:nil];
+        start = CFAbsoluteTimeGetCurrent();
+        [info normalized];
+        [record setDuration:CFAbsoluteTimeGetCurrent() - start forStage:kMTTraceStageNormalize];
+        start = CFAbsoluteTimeGetCurrent();
+        [info normalForm];
+        [record setDuration:CFAbsoluteTimeGetCurrent() - start forStage:kMTTraceStageNormalForm];
+        if ([original durationForStage:kMTTraceStageAnalysis] >= 0) {
+            start = CFAbsoluteTimeGetCurrent();
+            [MTExpressionAnalysis hasCheckableAnswer:info];
+            [record setDuration:CFAbsoluteTimeGetCurrent() - start forStage:kMTTraceStageAnalysis];
+        }
+    }
+    return [self traceWithRecords:records];
+}
+
+- (NSTimeInterval)percentile:(double)fraction forStage:(MTTraceStage)stage
+{
+    NSMutableArray* durations = [NSMutableArray arrayWithCapacity:self.records.count];
+    for (MTTraceRecord* record in self.records) {
+        NSTimeInterval duration = [record durationForStage:stage];
+        if (duration >= 0) {
+            [durations addObject:@(duration)];
+        }
+    }
+    if (durations.count == 0) {
+        return 0;
+    }
+    [durations sortUsingSelector:@selector(compare:)];
+    // nearest rank, allowing for rounding in the product
+    NSUInteger rank = (NSUInteger) ceil(fraction * durations.count - 1e-9);
+    NSUInteger index = (rank > 0) ? MIN(rank, durations.count) - 1 : 0;
+    return [durations[index] doubleValue];
+}
+
+- (NSString *)report
+{
+    NSMutableString* report = [NSMutableString stringWithFormat:@"%lu inputs (ms)\n", (unsigned long) self.records.count];
+    for (int stage = 0; stage < kMTTraceStageCount; stage++) {
+        [report appendFormat:@"%@: p50 %.3f p90 %.3f p99 %.3f max %.3f\n", stageName(stage),
+         [self percentile:0.5 forStage:stage] * 1000, [self percentile:0.9 forStage:stage] * 1000,
+         [self percentile:0.99 forStage:stage] * 1000, [self percentile:1 forStage:stage] * 1000];
+    }
+    return report;
+}
+
+- (NSArray *)regressionsFromBaseline:(MTTrace *)baseline factor:(double)factor minimumDifference:(NSTimeInterval)minimumDifference
+{
+    NSMutableDictionary* baselineRecords = [NSMutableDictionary dictionaryWithCapacity:baseline.records.count];
+    for (MTTraceRecord* record in baseline.records) {
+        // Use the first occurrence of an input.
+        if (!baselineRecords[record.key]) {
+            baselineRecords[record.key] = record;
+        }
+    }
+    NSMutableArray* regressions = [NSMutableArray array];
+    for (MTTraceRecord* record in self.records) {
+        MTTraceRecord* before = baselineRecords[record.key];
+        if (!before) {
+            continue;
+        }
+        NSTimeInterval oldDuration = before.totalDuration;
+        NSTimeInterval newDuration = record.totalDuration;
+        if (newDuration > factor * oldDuration && newDuration - oldDuration >= minimumDifference) {
+            InfoLog(@"Regression: %@ was %.3f ms", record, oldDuration * 1000);
+            [regressions addObject:record];
+        }
+    }
+    return regressions;
+}
+
+@end
+
+#pragma mark - MTTraceRecorder
+
+// The default number of records kept by a recorder.
+static const NSUInteger kMTTraceDefaultCapacity = 10000;
+
+// The shared recorder, guarded by the MTTraceRecorder class. It is read on every parse, so whether there is one is also
+// kept in an atomic flag, which lets the readers skip the lock while recording is off.
+static MTTraceRecorder* sharedRecorder = nil;
+static atomic_bool hasSharedRecorder = false;
+
+@implementation MTTraceRecorder {
+    // A ring buffer of the most recent records, oldest at _next once it is full.
+    NSMutableArray* _records;
+    NSUInteger _capacity;
+    NSUInteger _next;
+    // entity -> record for the entities returned by the parser. Compared by pointer since the stages are for that entity.
+    NSMapTable* _entityRecords;
+}
+
++ (MTTraceRecorder *)sharedRecorder
+{
+    if (!atomic_load_explicit(&hasSharedRecorder, memory_order_acquire)) {
+        return nil;
+    }
+    // The reader retains the recorder under the lock, so it stays alive if another one is set meanwhile.
+    MTTraceRecorder* recorder;
+    @synchronized([MTTraceRecorder class]) {
+        recorder = sharedRecorder;
+    }
+    return recorder;
+}
+
++ (void)setSharedRecorder:(MTTraceRecorder *)recorder
+{
+    @synchronized([MTTraceRecorder class]) {
+        sharedRecorder = recorder;
+        atomic_store_explicit(&hasSharedRecorder, recorder != nil, memory_order_release);
+    }
+}
+
+- (id) init
+{
+    return [self initWithCapacity:kMTTraceDefaultCapacity];
+}
+
+- (instancetype) initWithCapacity:(NSUInteger) capacity
+{
+    NSParameterAssert(capacity > 0);
+    self = [super init];
+    if (self) {
+        _capacity = capacity;
+        _records = [NSMutableArray arrayWithCapacity:MIN(capacity, kMTTraceDefaultCapacity)];
+        _entityRecords = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality
+                                               valueOptions:NSPointerFunctionsStrongMemory];
+    }
+    return self;
+}
+
+- (MTTrace *)trace
+{
+    @synchronized(self) {
+        if (_next == 0) {
+            return [MTTrace traceWithRecords:_records];
+        }
+        NSMutableArray* records = [NSMutableArray arrayWithCapacity:_records.count];
+        [records addObjectsFromArray:[_records subarrayWithRange:NSMakeRange(_next, _records.count - _next)]];
+        [records addObjectsFromArray:[_records subarrayWithRange:NSMakeRange(0, _next)]];
+        return [MTTrace traceWithRecords:records];
+    }
+}
+
+- (void)recordParseOfInput:(NSString *)input isMathList:(BOOL)isMathList entityType:(MTMathEntityType)entityType
+                    result:(id<MTMathEntity>)entity duration:(NSTimeInterval)duration
+{
+    // Keep each record on a single line.
+    NSString* singleLine = [[input componentsSeparatedByCharactersInSet:[NSCharacterSet newlineCharacterSet]] componentsJoinedByString:@" "];
+    singleLine = [singleLine stringByReplacingOccurrencesOfString:@"\t" withString:@" "];
+    MTTraceRecord* record = [MTTraceRecord recordWithInput:singleLine isMathList:isMathList entityType:entityType];
+    [record setDuration:duration forStage:kMTTraceStageParse];
+    @synchronized(self) {
+        if (_records.count < _capacity) {
+            [_records addObject:record];
+        } else {
+            // Replace the oldest record.
+            _records[_next] = record;
+            _next = (_next + 1) % _capacity;
+        }
+        if (entity) {
+            [_entityRecords setObject:record forKey:entity];
+        }
+    }
+}
+
+- (void)recordStage:(MTTraceStage)stage forEntity:(id<MTMathEntity>)entity duration:(NSTimeInterval)duration
+{
+    if (!entity) {
+        return;
+    }
+    @synchronized(self) {
+        MTTraceRecord* record = [_entityRecords objectForKey:entity];
+        [record setDuration:duration forStage:stage];
+    }
+}
+
+@end
@@ -11,31 +11,40 @@
 #import "MTCalculateRule.h"
 #import "MTExpression.h"
 
+// The number of numbers reduced using a buffer on the stack.
+static const NSUInteger kMTCalculateStackCount = 16;
+
 @implementation MTCalculateRule
 
 - (MTExpression*) applyToTopLevelNode:(MTExpression *)expr withChildren:(NSArray *)args
 {
-    if (expr.expressionType != kMTExpressionTypeOperator) {
-        return expr;
-    }
-    if ([expr equalsExpressionValue:kMTDivision]) {
-        
-        NSAssert(args.count == 2, @"Division with more than 2 arguments: %@", args);
-        
-        MTExpression* dividend = args[0];
-        MTExpression* divisor = args[1];
-        if (divisor.expressionType == kMTExpressionTypeNumber) {
-            MTExpression* divided = [self performDivision:(MTNumber*)divisor dividend:dividend];
-            if (divided) {
-                return divided;
+    switch (expr.opcode) {
+        case kMTOpcodeDivision: {
+            NSAssert(args.count == 2, @"Division with more than 2 arguments: %@", args);
+
+            MTExpression* dividend = args[0];
+            MTExpression* divisor = args[1];
+            if (divisor.opcode == kMTOpcodeNumber) {
+                MTExpression* divided = [self performDivision:(MTNumber*)divisor dividend:dividend];
+                if (divided) {
+                    return divided;
+                }
             }
+            break;
         }
-    } else if ([expr equalsExpressionValue:kMTAddition] || [expr equalsExpressionValue:kMTMultiplication]) {
-        MTOperator* oper = (MTOperator*) expr;
-        MTExpression* reduced = [self calculate:args operator:oper.type];
-        if (reduced) {
-            return reduced;
+
+        case kMTOpcodeAddition:
+        case kMTOpcodeMultiplication: {
+            MTOperator* oper = (MTOperator*) expr;
+            MTExpression* reduced = [self calculate:args operator:oper.type];
+            if (reduced) {
+                return reduced;
+            }
+            break;
         }
+
+        default:
+            break;
     }
     
     return expr;
@@ -56,7 +65,7 @@
                 return multiplication;
                 
             case kMTExpressionTypeOperator:
-                if ([dividend equalsExpressionValue:kMTMultiplication]) {
+                if (dividend.opcode == kMTOpcodeMultiplication) {
                     // for a multiplication, perform a reduce
                     NSMutableArray* newArgs = [NSMutableArray arrayWithArray:dividend.children];
                     [newArgs addObject:[MTNumber numberWithValue:divisorValue.reciprocal]];
@@ -77,56 +86,85 @@
 
 - (MTExpression*) calculate:(NSArray *)children operator:(char)operType
 {
-    NSMutableArray* newArgs = [NSMutableArray arrayWithCapacity:[children count]];
-    NSMutableArray* numbersToOperateOn = [NSMutableArray arrayWithCapacity:[children count]];
-    
+    // Most nodes have at most one number, so count them before allocating anything.
+    NSUInteger numbers = 0;
+    for (MTExpression *arg in children) {
+        if (arg.opcode == kMTOpcodeNumber) {
+            numbers++;
+        }
+    }
+    if (numbers < 2) {
+        return nil;
+    }
+
+    NSMutableArray* newArgs = [NSMutableArray arrayWithCapacity:[children count] - numbers];
+    NSMutableArray* numbersToOperateOn = [NSMutableArray arrayWithCapacity:numbers];
     for (MTExpression *arg in children) {
-        if ([arg isKindOfClass:[MTNumber class]]) {
+        if (arg.opcode == kMTOpcodeNumber) {
             [numbersToOperateOn addObject:arg];
         } else {
             [newArgs addObject:arg];
         }
     }
-    if ([numbersToOperateOn count] > 1) {
-        MTNumber* number = [self reduce:numbersToOperateOn withOperator:operType];
-        if ([newArgs count] == 0) {
-            // there are no non-number expressions, so remove the operator
-            return number;
-        } else {
-            [newArgs addObject:number];
-            return [MTOperator operatorWithType:operType args:newArgs];
-        }
+    MTNumber* number = [self reduce:numbersToOperateOn withOperator:operType];
+    if ([newArgs count] == 0) {
+        // there are no non-number expressions, so remove the operator
+        return number;
+    } else {
+        [newArgs addObject:number];
+        return [MTOperator operatorWithType:operType args:newArgs];
     }
-    return nil;
 }
 
 
 - (MTNumber*) reduce:(NSArray*) numbers withOperator:(char) operType
 {
+    // Operate on all the numbers at once instead of creating a rational for every partial result.
+    NSUInteger count = numbers.count;
+    // Most operators have only a few numbers, so avoid the heap for them.
+    NSInteger buffer[2 * kMTCalculateStackCount];
+    NSInteger* numerators = (count <= kMTCalculateStackCount) ? buffer : malloc(2 * count * sizeof(NSInteger));
+    NSInteger* denominators = numerators + count;
+    for (NSUInteger i = 0; i < count; i++) {
+        MTRational* value = [numbers[i] value];
+        numerators[i] = value.numerator;
+        denominators[i] = value.denominator;
+    }
+    MTRational* answer;
     switch (operType) {
         case '+':
-        {
-            MTRational* answer = [MTRational zero];
-            for (MTNumber* arg in numbers) {
-                answer = [answer add:arg.value];
-            }
-            return [MTNumber numberWithValue:answer];
-        }
+            answer = [MTRational sumOfNumerators:numerators denominators:denominators count:count];
+            break;
+
         case '*':
-        {
-            MTRational* answer = [MTRational one];
-            for (MTNumber* arg in numbers) {
-                answer = [answer multiply:arg.value];
-            }
-            return [MTNumber numberWithValue:answer];
-        }
-            
+            answer = [MTRational productOfNumerators:numerators denominators:denominators count:count];
+            break;
+
         default:
+            if (numerators != buffer) {
+                free(numerators);
+            }
             @throw [NSException exceptionWithName:@"RuleEvaluationError"
                                            reason:[NSString stringWithFormat:@"Unknown operator %c during evaluation", operType]
                                          userInfo:nil];
-            
     }
+    if (numerators != buffer) {
+        free(numerators);
+    }
+    if (!answer) {
+        // The result may overflow, fall back to operating on one number at a time.
+        answer = [self fold:numbers withOperator:operType];
+    }
+    return [MTNumber numberWithValue:answer];
+}
+
+- (MTRational*) fold:(NSArray*) numbers withOperator:(char) operType
+{
+    MTRational* answer = (operType == '+') ? [MTRational zero] : [MTRational one];
+    for (MTNumber* arg in numbers) {
+        answer = (operType == '+') ? [answer add:arg.value] : [answer multiply:arg.value];
+    }
+    return answer;
 }
 
 @end
@@ -12,6 +12,42 @@
 #import "MTExpression.h"
 #import "MTExpressionUtil.h"
 
+// A like term with its monomial packed into a key: the degree in the top byte followed by the names of the sorted
+// variables. The index is the position of the term among the terms which can be collected.
+typedef struct {
+    uint64_t key;
+    NSUInteger index;
+} MTLikeTerm;
+
+static const NSUInteger kMaxPackedVariables = 7;
+// The number of terms collected using buffers on the stack.
+static const NSUInteger kMTCollectStackCount = 16;
+
+static BOOL packMonomial(NSArray* vars, uint64_t* key)
+{
+    if (vars.count > kMaxPackedVariables) {
+        return NO;
+    }
+    uint64_t packed = (uint64_t) vars.count << 56;
+    int shift = 48;
+    for (MTVariable* var in vars) {
+        packed |= (uint64_t) (unsigned char) var.name << shift;
+        shift -= 8;
+    }
+    *key = packed;
+    return YES;
+}
+
+static int compareLikeTerms(const void* a, const void* b)
+{
+    const MTLikeTerm* x = a;
+    const MTLikeTerm* y = b;
+    if (x->key != y->key) {
+        return (x->key < y->key) ? -1 : 1;
+    }
+    return (x->index < y->index) ? -1 : (x->index > y->index);
+}
+
 @implementation MTCollectLikeTermsRule
 
 
@@ -23,47 +59,130 @@
         return expr;
     }
 
-    NSMutableArray* otherTerms = [NSMutableArray arrayWithCapacity:[args count]];
-    NSMutableDictionary* dict = [NSMutableDictionary dictionary];
+    NSUInteger count = args.count;
+    NSMutableArray* otherTerms = [NSMutableArray arrayWithCapacity:count];
+    // The variables and coefficients of the terms which can be collected, in the order they appear.
+    NSMutableArray* variables = [NSMutableArray arrayWithCapacity:count];
+    NSMutableArray* coefficients = [NSMutableArray arrayWithCapacity:count];
+    // Most additions have only a few terms, so avoid the heap for them.
+    MTLikeTerm termBuffer[kMTCollectStackCount];
+    BOOL isNumberBuffer[kMTCollectStackCount];
+    MTLikeTerm* terms = (count <= kMTCollectStackCount) ? termBuffer : malloc(count * sizeof(MTLikeTerm));
+    BOOL* isNumber = (count <= kMTCollectStackCount) ? isNumberBuffer : malloc(count * sizeof(BOOL));
+    // Monomials with too many variables to pack are collected in a dictionary.
+    NSMutableDictionary* dict = nil;
+    NSUInteger numTerms = 0;
     BOOL combinedTerms = NO;
     for (MTExpression* arg in args) {
         NSArray* vars;
         MTRational* coefficent;
         if ([MTExpressionUtil expression:arg getCoefficent:&coefficent variables:&vars]) {
-            if (arg.expressionType == kMTExpressionTypeNumber) {
+            uint64_t key;
+            if (packMonomial(vars, &key)) {
+                terms[numTerms].key = key;
+                terms[numTerms].index = variables.count;
                 // numbers get combined if it is a CLT but by themselves don't trigger a CLT rule
-                [self combineTerms:vars withValue:coefficent inDict:dict];
+                isNumber[variables.count] = (arg.expressionType == kMTExpressionTypeNumber);
+                numTerms++;
             } else {
+                if (!dict) {
+                    dict = [NSMutableDictionary dictionary];
+                }
                 combinedTerms |= [self combineTerms:vars withValue:coefficent inDict:dict];
             }
+            [variables addObject:vars];
+            [coefficients addObject:coefficent];
         } else {
             // not combinable
             [otherTerms addObject:arg];
         }
     }
-    
-    if (combinedTerms) {
-        // if we combined the terms, then create a new expression with the combined terms
-        for (NSArray* key in dict) {
-            MTRational* coeff = [dict objectForKey:key];
-            MTNumber* coeffNum = [MTNumber numberWithValue:coeff];
-            if (key.count > 0) {
-                NSMutableArray* args = [NSMutableArray arrayWithObject:coeffNum];
-                [args addObjectsFromArray:key];
-                [otherTerms addObject:[MTOperator operatorWithType:kMTMultiplication args:args]];
-            } else {
-                // no variables, just a number
-                [otherTerms addObject:coeffNum];
+
+    // Sorting brings the like terms together, each in the order it appears in the expression.
+    qsort(terms, numTerms, sizeof(MTLikeTerm), compareLikeTerms);
+    for (NSUInteger i = 1; i < numTerms; i++) {
+        if (terms[i].key == terms[i - 1].key && !isNumber[terms[i].index]) {
+            combinedTerms = YES;
+        }
+    }
+    if (isNumber != isNumberBuffer) {
+        free(isNumber);
+    }
+
+    if (!combinedTerms) {
+        if (terms != termBuffer) {
+            free(terms);
+        }
+        return expr;
+    }
+
+    // if we combined the terms, then create a new expression with the combined terms
+    NSInteger valueBuffer[2 * kMTCollectStackCount];
+    NSInteger* numerators = (numTerms <= kMTCollectStackCount) ? valueBuffer : malloc(2 * numTerms * sizeof(NSInteger));
+    NSInteger* denominators = numerators + numTerms;
+    for (NSUInteger i = 0; i < numTerms; i++) {
+        MTRational* coeff = coefficients[terms[i].index];
+        numerators[i] = coeff.numerator;
+        denominators[i] = coeff.denominator;
+    }
+    NSUInteger start = 0;
+    while (start < numTerms) {
+        NSUInteger end = start + 1;
+        while (end < numTerms && terms[end].key == terms[start].key) {
+            end++;
+        }
+        if (end - start > 1) {
+            MTRational* coeff = [MTRational sumOfNumerators:numerators + start denominators:denominators + start count:end - start];
+            if (!coeff) {
+                // The sum may overflow, add the coefficients one at a time.
+                coeff = coefficients[terms[start].index];
+                for (NSUInteger i = start + 1; i < end; i++) {
+                    coeff = [coeff add:coefficients[terms[i].index]];
+                }
             }
+            // The sum replaces the coefficient of the first like term.
+            coefficients[terms[start].index] = coeff;
         }
-        assert([otherTerms count] > 0);
-        if ([otherTerms count] == 1) {
-            // skip the addition operator
-            return [otherTerms lastObject];
+        start = end;
+    }
+    if (numerators != valueBuffer) {
+        free(numerators);
+    }
+    if (terms != termBuffer) {
+        free(terms);
+    }
+
+    // The first like term now has the sum of the coefficients, so adding the terms to a dictionary in the order they
+    // appear gives the same terms in the same order as combining them in it one at a time.
+    NSMutableDictionary* collected = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < variables.count; i++) {
+        NSArray* vars = variables[i];
+        if (![collected objectForKey:vars]) {
+            MTRational* coeff = [dict objectForKey:vars];
+            [collected setObject:(coeff ? coeff : coefficients[i]) forKey:vars];
         }
-        return [MTOperator operatorWithType:kMTAddition args:otherTerms];
+    }
+    for (NSArray* key in collected) {
+        [otherTerms addObject:[self termWithCoefficient:[collected objectForKey:key] variables:key]];
+    }
+    assert([otherTerms count] > 0);
+    if ([otherTerms count] == 1) {
+        // skip the addition operator
+        return [otherTerms lastObject];
+    }
+    return [MTOperator operatorWithType:kMTAddition args:otherTerms];
+}
+
+- (MTExpression*) termWithCoefficient:(MTRational*) coeff variables:(NSArray*) vars
+{
+    MTNumber* coeffNum = [MTNumber numberWithValue:coeff];
+    if (vars.count > 0) {
+        NSMutableArray* args = [NSMutableArray arrayWithObject:coeffNum];
+        [args addObjectsFromArray:vars];
+        return [MTOperator operatorWithType:kMTMultiplication args:args];
     } else {
-        return expr;
+        // no variables, just a number
+        return coeffNum;
     }
 }
 
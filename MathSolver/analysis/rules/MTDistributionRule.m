@@ -73,13 +73,13 @@
 +(BOOL) isDistributee:(MTExpression*) expr
 {
     // We can only distribute over addition
-    return expr.expressionType == kMTExpressionTypeOperator && [expr equalsExpressionValue:kMTAddition];
+    return expr.opcode == kMTOpcodeAddition;
 }
 
 +(BOOL) isDistributableOperator:(MTExpression *)expr
 {
     // Only multiplication operators can have distributees
-    return expr.expressionType == kMTExpressionTypeOperator && [expr equalsExpressionValue:kMTMultiplication];
+    return expr.opcode == kMTOpcodeMultiplication;
 }
 
 +(BOOL) canDistribute:(MTExpression*) expr
@@ -8,8 +8,8 @@
 //  MIT license. See the LICENSE file for details.
 //
 
-#import "MTRule.h"
+#import "MTRewriteRule.h"
 
-@interface MTDivisionIdentityRule : MTRule
+@interface MTDivisionIdentityRule : MTRewriteRuleSet
 
 @end
@@ -9,22 +9,12 @@
 //
 
 #import "MTDivisionIdentityRule.h"
-#import "MTExpression.h"
-#import "MTExpressionUtil.h"
 
 @implementation MTDivisionIdentityRule
 
-- (MTExpression*) applyToTopLevelNode:(MTExpression *)expr withChildren:(NSArray *)args
++ (NSArray*) rewriteRules
 {
-    if ([MTExpressionUtil isDivision:expr]) {
-        NSAssert(args.count == 2, @"A division can only have 2 arguments.");
-        MTExpression* first = args[0];
-        MTExpression* second = args[1];
-        if ([second isEqual:[MTExpressionUtil getIdentity:kMTMultiplication]]) {
-            return first;
-        }
-    }
-    return expr;
+    return @[ @"(/ a 1) => a" ];
 }
 
 @end
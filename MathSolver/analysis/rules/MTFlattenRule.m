@@ -22,7 +22,7 @@
         BOOL flattened = NO;
         for (MTExpression *arg in args) {
             // if the operator is of the same type as the parent, we can flatten out any arguments since our operators are commutative and associative.
-            if (arg.expressionType == kMTExpressionTypeOperator && [arg equalsExpressionValue:oper.type]) {
+            if (arg.opcode == oper.opcode) {
                 [newArgs addObjectsFromArray:[arg children]];
                 flattened = YES;       
             } else {
@@ -31,8 +31,7 @@
         }
         if (flattened) {
             // at least one child was flattened then rebuild the expression
-            // Note: the range does not change.
-            return [MTOperator operatorWithType:oper.type args:newArgs range:oper.range];
+            return [MTOperator operatorWithType:oper.type args:newArgs];
         }
     }
     return expr;
@@ -8,12 +8,9 @@
 //  MIT license. See the LICENSE file for details.
 //
 
-#import "MTRule.h"
-#import "MTExpression.h"
+#import "MTRewriteRule.h"
 
 // Removes addititive and multiplicative identities.
-@interface MTIdentityRule : MTRule
-
-- (MTExpression*) applyToTopLevelNode:(MTExpression *)expr withChildren:(NSArray *)args;
+@interface MTIdentityRule : MTRewriteRuleSet
 
 @end
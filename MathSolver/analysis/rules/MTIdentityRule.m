@@ -9,36 +9,14 @@
 //
 
 #import "MTIdentityRule.h"
-#import "MTExpression.h"
-#import "MTExpressionUtil.h"
 
 @implementation MTIdentityRule
 
-- (MTExpression*) applyToTopLevelNode:(MTExpression *)expr withChildren:(NSArray *)args
++ (NSArray*) rewriteRules
 {
     // Removes addition and multiplication identities from the operators.
-    if (expr.expressionType != kMTExpressionTypeOperator) {
-        return expr;
-    }
-    MTOperator *oper = (MTOperator *) expr;
-    MTNumber* identity = [MTExpressionUtil getIdentity:oper.type];
-    if (!identity) {
-        return expr;
-    }
-    for (MTExpression *arg in args) {
-        if ([arg isEqual:identity]) {
-            NSMutableArray* newArgs = [NSMutableArray arrayWithArray:args];
-            [newArgs removeObject:arg];
-            assert([newArgs count] > 0);
-            if ([newArgs count] == 1) {
-                return [newArgs lastObject];
-            } else {
-                return [MTOperator operatorWithType:oper.type args:newArgs];
-            }
-        }
-    }
-    
-    return expr;
+    return @[ @"(+ 0 ...rest) => (+ ...rest)",
+              @"(* 1 ...rest) => (* ...rest)" ];
 }
 
 @end
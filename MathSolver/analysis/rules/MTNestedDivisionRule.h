@@ -8,11 +8,11 @@
 //  MIT license. See the LICENSE file for details.
 //
 
-#import "MTRule.h"
+#import "MTRewriteRule.h"
 
 // If there is a division inside a division, this converts the second division to a multiplication
 // e.g. (a/b) / c => a / (b*c)
 // and  a / (b/c) => (a*c) / b
-@interface MTNestedDivisionRule : MTRule
+@interface MTNestedDivisionRule : MTRewriteRuleSet
 
 @end
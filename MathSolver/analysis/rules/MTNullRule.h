@@ -8,9 +8,9 @@
 //  MIT license. See the LICENSE file for details.
 //
 
-#import "MTRule.h"
+#import "MTRewriteRule.h"
 
 // Removes any subexpressions which are FxNull
-@interface MTNullRule : MTRule
+@interface MTNullRule : MTRewriteRuleSet
 
 @end
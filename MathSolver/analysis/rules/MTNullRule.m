@@ -9,23 +9,13 @@
 //
 
 #import "MTNullRule.h"
-#import "MTExpression.h"
 
 @implementation MTNullRule
 
-- (MTExpression *)applyToTopLevelNode:(MTExpression *)expr withChildren:(NSArray *)args
++ (NSArray*) rewriteRules
 {
-    // This rule only applies to operators
-    if (expr.expressionType != kMTExpressionTypeOperator) {
-        return expr;
-    }
-    // If any argument is null, this returns null.
-    for (MTExpression *arg in args) {
-        if (arg.expressionType == kMTExpressionTypeNull) {
-            return arg;
-        }
-    }
-    return expr;
+    // If any argument of an operator is null, this returns null.
+    return @[ @"(op n:null ...rest) => n" ];
 }
 
 @end
@@ -8,11 +8,11 @@
 //  MIT license. See the LICENSE file for details.
 //
 
-#import "MTRule.h"
+#import "MTRewriteRule.h"
 
 // Rule for adding rational functions. Does
 // a/b + c => (a + b*c) / b
 // TODO: Optimize by pulling out the common factors before adding.
-@interface MTRationalAdditionRule : MTRule
+@interface MTRationalAdditionRule : MTRewriteRuleSet
 
 @end
@@ -17,7 +17,7 @@
 - (MTExpression*) applyToTopLevelNode:(MTExpression *)expr withChildren:(NSArray *)args
 {
     // traverse the expressions to find any -ve signs and unary minus
-    if ([expr isKindOfClass:[MTOperator class]]) {
+    if (expr.expressionType == kMTExpressionTypeOperator) {
         MTOperator *oper = (MTOperator *) expr;
         if (oper.type == kMTUnaryMinus) {
             assert([args count] == 1);
@@ -36,9 +36,9 @@
             MTExpression *arg2 = [args lastObject];
             MTExpression* arg2WithNegative = [self addNegativeSignIfPossible:arg2];
             if (arg2WithNegative) {
-                return [MTOperator operatorWithType:kMTAddition args:arg1 :arg2WithNegative range:expr.range];
+                return [MTOperator operatorWithType:kMTAddition args:arg1 :arg2WithNegative];
             } else {
-                return [MTOperator operatorWithType:kMTAddition args:arg1 :[MTExpressionUtil negate:arg2] range:expr.range];
+                return [MTOperator operatorWithType:kMTAddition args:arg1 :[MTExpressionUtil negate:arg2]];
             }
         }
     }
@@ -50,14 +50,14 @@
     if (expr.expressionType == kMTExpressionTypeNumber) {
         // convert the number to it's negative
         MTNumber* num = (MTNumber *) expr;
-        return [MTNumber numberWithValue:num.value.negation range:num.range];
-    } else if (expr.expressionType == kMTExpressionTypeOperator && [expr equalsExpressionValue:kMTMultiplication]) {
+        return [MTNumber numberWithValue:num.value.negation];
+    } else if (expr.opcode == kMTOpcodeMultiplication) {
         // recurse
         MTExpression* neg = [self addNegativeSignIfPossible:expr.children[0]];
         if (neg) {
             NSArray* args = [NSArray arrayWithObject:neg];
             args = [args arrayByAddingObjectsFromArray:[expr.children subarrayWithRange:NSMakeRange(1, expr.children.count - 1)]];
-            return [MTOperator operatorWithType:kMTMultiplication args:args range:expr.range];
+            return [MTOperator operatorWithType:kMTMultiplication args:args];
         }
     }
     return nil;
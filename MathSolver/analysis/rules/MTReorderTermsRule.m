@@ -83,28 +83,30 @@ NSComparisonResult compareVariableToOperatorForAddition(MTOperator *op1, MTVaria
 
 NSArray* reorderForMultiplication(const NSArray* args) {
     return[args sortedArrayUsingComparator:^NSComparisonResult(id obj1, id obj2) {
-        if ([obj1 isKindOfClass:[MTNumber class]]) {
-            if ([obj2 isKindOfClass:[MTNumber class]]) {
+        MTExpression* ex1 = obj1;
+        MTExpression* ex2 = obj2;
+        if (ex1.expressionType == kMTExpressionTypeNumber) {
+            if (ex2.expressionType == kMTExpressionTypeNumber) {
                 MTNumber* n1 = obj1;
                 return [n1 compare:obj2];
             } else {
                 // numbers come before operators and variables
                 return NSOrderedAscending;
             }
-        } else if ([obj1 isKindOfClass:[MTVariable class]]) {
-            if ([obj2 isKindOfClass:[MTNumber class]]) {
+        } else if (ex1.expressionType == kMTExpressionTypeVariable) {
+            if (ex2.expressionType == kMTExpressionTypeNumber) {
                 // numbers come before variables.
                 return NSOrderedDescending;
-            } else if ([obj2 isKindOfClass:[MTVariable class]]) {
+            } else if (ex2.expressionType == kMTExpressionTypeVariable) {
                 MTVariable* v1 = obj1;
                 return [v1 compare:obj2];
             } else {
-                assert([obj2 isKindOfClass:[MTOperator class]]);
+                assert(ex2.expressionType == kMTExpressionTypeOperator);
                 // variables always come before operators
                 return NSOrderedAscending;
             }
-        } else if ([obj1 isKindOfClass:[MTOperator class]]) {
-            if([obj2 isKindOfClass:[MTOperator class]]) {
+        } else if (ex1.expressionType == kMTExpressionTypeOperator) {
+            if(ex2.expressionType == kMTExpressionTypeOperator) {
                 // Should 2x + 1 be lower than x + 2? Don't know, don't really care since this rule should be applied after canoncicalization. Return same for simplicity.
                 return NSOrderedSame;
             } else {
@@ -136,21 +138,21 @@ NSArray* reorderForAddition(const NSArray* args) {
             return NSOrderedDescending;
         } else {
             // lexicographic ordering of variables
-            if ([obj1 isKindOfClass:[MTNumber class]]) {
-                if ([obj2 isKindOfClass:[MTNumber class]]) {
+            if (ex1.expressionType == kMTExpressionTypeNumber) {
+                if (ex2.expressionType == kMTExpressionTypeNumber) {
                     MTNumber* n1 = obj1;
                     return [n1 compare:obj2];
                 } else {
-                    assert([obj2 isKindOfClass:[MTOperator class]]);
+                    assert(ex2.expressionType == kMTExpressionTypeOperator);
                     // numbers come before operators
                     return NSOrderedAscending;
                 }
-            } else if ([obj1 isKindOfClass:[MTVariable class]]) {
-                if ([obj2 isKindOfClass:[MTVariable class]]) {
+            } else if (ex1.expressionType == kMTExpressionTypeVariable) {
+                if (ex2.expressionType == kMTExpressionTypeVariable) {
                     MTVariable* v1 = obj1;
                     return [v1 compare:obj2];
                 } else {
-                    assert([obj2 isKindOfClass:[MTOperator class]]);
+                    assert(ex2.expressionType == kMTExpressionTypeOperator);
                     NSComparisonResult result = compareVariableToOperatorForAddition(obj2, obj1);
                     // note the compare function compares obj2 to obj1, so we need to reverse the result
                     if (result == NSOrderedDescending) {
@@ -161,10 +163,10 @@ NSArray* reorderForAddition(const NSArray* args) {
                         return NSOrderedSame;
                     }
                 }
-            } else if ([obj1 isKindOfClass:[MTOperator class]]) {
-                if([obj2 isKindOfClass:[MTOperator class]]) {
+            } else if (ex1.expressionType == kMTExpressionTypeOperator) {
+                if(ex2.expressionType == kMTExpressionTypeOperator) {
                     return compareOperatorsForAddition(obj1, obj2);
-                } else if ([obj2 isKindOfClass:[MTVariable class]]) {
+                } else if (ex2.expressionType == kMTExpressionTypeVariable) {
                     return compareVariableToOperatorForAddition(obj1, obj2);
                 } else {
                     // operators come after numbers
@@ -182,7 +184,7 @@ NSArray* reorderForAddition(const NSArray* args) {
 - (MTExpression*) applyToTopLevelNode:(MTExpression *)expr withChildren:(NSArray *)args
 {
     // Removes addition and multiplication identities from the operators.
-    if (![expr isKindOfClass:[MTOperator class]]) {
+    if (expr.expressionType != kMTExpressionTypeOperator) {
         return expr;
     }
     MTOperator *oper = (MTOperator *) expr;
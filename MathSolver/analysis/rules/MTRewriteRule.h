@@ -0,0 +1,52 @@
+//
+//  MTRewriteRule.h
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import "MTRule.h"
+
+// A rewrite rule of the form pattern => replacement, e.g. @"(/ (/ a b) c) => (/ a (* b c))".
+//
+// Patterns:
+//   (op p1 p2 ...)  An operator of type op (one of + - * / _) whose children match p1, p2, ... in order.
+//                   Using the word op as the type matches any operator.
+//   (op p ...r)     An operator with some child matching p. The first such child is used and the other children
+//                   are bound to r in order.
+//   a               Any expression, bound to a. If a name is used more than once the expressions must be equal.
+//   a:kind          An expression of the given kind bound to a. The kinds are num, var, op, null and zero, which is
+//                   a number equivalent to 0.
+//   5               A number equal to 5.
+//
+// The replacement uses the same syntax with the names bound by the pattern. ...r inserts the children bound to r
+// and an operator with a single child after inserting them is replaced by that child.
+@interface MTRewriteRule : NSObject
+
+// Returns nil if the string is not a valid rule.
++ (instancetype) ruleWithString:(NSString*) string;
+
+@property (nonatomic, readonly) NSString* string;
+
+@end
+
+// Applies the first rewrite rule that matches a node. The patterns are compiled into a discrimination tree on the
+// type of the node and the types of its children, so all the rules are matched in one lookup per node and only
+// the rules which can match are tried.
+@interface MTRewriteRuleSet : MTRule
+
+// A rule set of the given rules (MTRewriteRule) in order of preference. At most 64 rules are supported.
++ (instancetype) ruleSetWithRules:(NSArray*) rules;
+
+// A rule set trying the rules of each rule set (MTRewriteRuleSet) in order.
++ (instancetype) ruleSetCombining:(NSArray*) ruleSets;
+
+// The rules (NSString) of the set created with +rule. Subclasses override this.
++ (NSArray*) rewriteRules;
+
+@property (nonatomic, readonly) NSArray* rules;
+
+@end
@@ -0,0 +1,561 @@
+//
+//  MTRewriteRule.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import "MTRewriteRule.h"
+#import "MTExpression.h"
+
+static const uint32_t kMTOperatorHeads = (1 << kMTOpcodeAddition) | (1 << kMTOpcodeSubtraction) | (1 << kMTOpcodeMultiplication)
+                                         | (1 << kMTOpcodeDivision) | (1 << kMTOpcodeUnaryMinus) | (1 << kMTOpcodeUnknownOperator);
+static const uint32_t kMTAllHeads = (1 << kMTOpcodeCount) - 1;
+
+static const NSUInteger kMTMaxRewriteRules = 64;
+
+#pragma mark - MTRewritePattern
+
+typedef enum {
+    // Any expression with one of the allowed opcodes, bound to the name.
+    kMTPatternBinding,
+    // A number equal to the value.
+    kMTPatternNumber,
+    // An operator whose children match the children.
+    kMTPatternOperator,
+    // The children bound to the name. Only in replacements.
+    kMTPatternRest,
+} MTPatternKind;
+
+// A node of a pattern or a replacement.
+@interface MTRewritePattern : NSObject
+
+@property (nonatomic) MTPatternKind kind;
+// The opcodes of the expressions this pattern can match.
+@property (nonatomic) uint32_t heads;
+@property (nonatomic) NSString* name;
+// The binding only matches numbers equivalent to 0.
+@property (nonatomic) BOOL zero;
+@property (nonatomic) MTNumber* value;
+// 0 for any operator.
+@property (nonatomic) char operatorType;
+@property (nonatomic) NSArray* children;
+// If set the single child matches any child and the others are bound to rest.
+@property (nonatomic) NSString* rest;
+
+@end
+
+@implementation MTRewritePattern
+@end
+
+#pragma mark - MTRewriteRuleParser
+
+@interface MTRewriteRuleParser : NSObject
+
+@property (nonatomic, readonly) NSString* error;
+
+- (instancetype) initWithString:(NSString*) string;
+- (MTRewritePattern*) parsePattern:(BOOL) isReplacement;
+- (BOOL) expectToken:(NSString*) token;
+- (BOOL) isAtEnd;
+
+@end
+
+@implementation MTRewriteRuleParser {
+    NSMutableArray* _tokens;
+    NSUInteger _index;
+}
+
+- (instancetype) initWithString:(NSString *)string
+{
+    self = [super init];
+    if (self) {
+        // Tokens are separated by spaces and parentheses.
+        _tokens = [NSMutableArray array];
+        NSMutableString* token = [NSMutableString string];
+        NSCharacterSet* whitespace = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+        for (NSUInteger i = 0; i < string.length; i++) {
+            unichar ch = [string characterAtIndex:i];
+            if (ch == '(' || ch == ')' || [whitespace characterIsMember:ch]) {
+                if (token.length > 0) {
+                    [_tokens addObject:[token copy]];
+                    [token setString:@""];
+                }
+                if (ch == '(' || ch == ')') {
+                    [_tokens addObject:[NSString stringWithCharacters:&ch length:1]];
+                }
+            } else {
+                [token appendFormat:@"%C", ch];
+            }
+        }
+        if (token.length > 0) {
+            [_tokens addObject:[token copy]];
+        }
+    }
+    return self;
+}
+
+- (NSString*) peekToken
+{
+    return (_index < _tokens.count) ? _tokens[_index] : nil;
+}
+
+- (NSString*) nextToken
+{
+    NSString* token = [self peekToken];
+    if (token) {
+        _index++;
+    }
+    return token;
+}
+
+- (BOOL) isAtEnd
+{
+    return _index == _tokens.count;
+}
+
+- (BOOL) expectToken:(NSString *)token
+{
+    NSString* next = [self nextToken];
+    if (![next isEqualToString:token]) {
+        _error = [NSString stringWithFormat:@"Expected %@ but found %@", token, next];
+        return NO;
+    }
+    return YES;
+}
+
+- (BOOL) isValidName:(NSString*) name
+{
+    NSCharacterSet* invalid = [[NSCharacterSet alphanumericCharacterSet] invertedSet];
+    return name.length > 0 && [name rangeOfCharacterFromSet:invalid].location == NSNotFound && ![name isEqualToString:@"op"];
+}
+
+- (MTRewritePattern*) parsePattern:(BOOL) isReplacement
+{
+    NSString* token = [self nextToken];
+    if (!token) {
+        _error = @"Unexpected end of rule";
+        return nil;
+    }
+    if ([token isEqualToString:@"("]) {
+        return [self parseOperator:isReplacement];
+    }
+
+    MTRewritePattern* pattern = [MTRewritePattern new];
+    NSScanner* scanner = [NSScanner scannerWithString:token];
+    NSInteger number;
+    if ([scanner scanInteger:&number] && scanner.isAtEnd) {
+        pattern.kind = kMTPatternNumber;
+        pattern.heads = 1 << kMTOpcodeNumber;
+        pattern.value = [MTNumber numberWithValue:[MTRational rationalWithNumber:number]];
+        return pattern;
+    }
+
+    NSArray* parts = [token componentsSeparatedByString:@":"];
+    if (![self isValidName:parts[0]] || parts.count > 2 || (isReplacement && parts.count > 1)) {
+        _error = [NSString stringWithFormat:@"Unexpected %@", token];
+        return nil;
+    }
+    pattern.kind = kMTPatternBinding;
+    pattern.name = parts[0];
+    pattern.heads = kMTAllHeads;
+    if (parts.count == 2) {
+        NSString* kind = parts[1];
+        if ([kind isEqualToString:@"num"]) {
+            pattern.heads = 1 << kMTOpcodeNumber;
+        } else if ([kind isEqualToString:@"zero"]) {
+            pattern.heads = 1 << kMTOpcodeNumber;
+            pattern.zero = YES;
+        } else if ([kind isEqualToString:@"var"]) {
+            pattern.heads = 1 << kMTOpcodeVariable;
+        } else if ([kind isEqualToString:@"null"]) {
+            pattern.heads = 1 << kMTOpcodeNull;
+        } else if ([kind isEqualToString:@"op"]) {
+            pattern.heads = kMTOperatorHeads;
+        } else {
+            _error = [NSString stringWithFormat:@"Unknown kind %@", kind];
+            return nil;
+        }
+    }
+    return pattern;
+}
+
+- (MTRewritePattern*) parseOperator:(BOOL) isReplacement
+{
+    MTRewritePattern* pattern = [MTRewritePattern new];
+    pattern.kind = kMTPatternOperator;
+    NSString* type = [self nextToken];
+    if ([type isEqualToString:@"op"] && !isReplacement) {
+        pattern.heads = kMTOperatorHeads;
+    } else if (type.length == 1 && MTOpcodeForOperatorType([type characterAtIndex:0]) != kMTOpcodeUnknownOperator) {
+        pattern.operatorType = [type characterAtIndex:0];
+        pattern.heads = 1 << MTOpcodeForOperatorType(pattern.operatorType);
+    } else {
+        _error = [NSString stringWithFormat:@"Unknown operator %@", type];
+        return nil;
+    }
+
+    NSMutableArray* children = [NSMutableArray array];
+    while (![[self peekToken] isEqualToString:@")"]) {
+        NSString* token = [self peekToken];
+        if ([token hasPrefix:@"..."]) {
+            [self nextToken];
+            NSString* name = [token substringFromIndex:3];
+            if (![self isValidName:name]) {
+                _error = [NSString stringWithFormat:@"Unexpected %@", token];
+                return nil;
+            }
+            if (isReplacement) {
+                MTRewritePattern* rest = [MTRewritePattern new];
+                rest.kind = kMTPatternRest;
+                rest.name = name;
+                [children addObject:rest];
+            } else if (pattern.rest || children.count != 1) {
+                _error = @"A pattern with ... needs exactly one other child";
+                return nil;
+            } else {
+                pattern.rest = name;
+            }
+        } else if (pattern.rest) {
+            _error = @"... must be the last child";
+            return nil;
+        } else {
+            MTRewritePattern* child = [self parsePattern:isReplacement];
+            if (!child) {
+                return nil;
+            }
+            [children addObject:child];
+        }
+    }
+    [self nextToken];
+    if (children.count == 0) {
+        _error = @"An operator needs at least one child";
+        return nil;
+    }
+    pattern.children = children;
+    return pattern;
+}
+
+@end
+
+#pragma mark - Matching
+
+static BOOL matchChildren(MTRewritePattern* pattern, NSArray* children, NSMutableDictionary* bindings);
+
+static BOOL matchPattern(MTRewritePattern* pattern, MTExpression* expr, NSMutableDictionary* bindings) {
+    if (!(pattern.heads & (1 << expr.opcode))) {
+        return NO;
+    }
+    switch (pattern.kind) {
+        case kMTPatternBinding: {
+            if (pattern.zero && ![((MTNumber*) expr).value isEquivalent:[MTRational zero]]) {
+                return NO;
+            }
+            MTExpression* bound = bindings[pattern.name];
+            if (bound) {
+                return [bound isEqual:expr];
+            }
+            bindings[pattern.name] = expr;
+            return YES;
+        }
+
+        case kMTPatternNumber:
+            return [pattern.value isEqual:expr];
+
+        case kMTPatternOperator:
+            return matchChildren(pattern, expr.children, bindings);
+
+        case kMTPatternRest:
+            break;
+    }
+    NSCAssert(false, @"Unexpected pattern kind %d", pattern.kind);
+    return NO;
+}
+
+static BOOL matchChildren(MTRewritePattern* pattern, NSArray* children, NSMutableDictionary* bindings) {
+    if (!pattern.rest) {
+        if (children.count != pattern.children.count) {
+            return NO;
+        }
+        for (NSUInteger i = 0; i < children.count; i++) {
+            if (!matchPattern(pattern.children[i], children[i], bindings)) {
+                return NO;
+            }
+        }
+        return YES;
+    }
+
+    MTRewritePattern* childPattern = pattern.children[0];
+    for (NSUInteger i = 0; i < children.count; i++) {
+        if (!(childPattern.heads & (1 << [children[i] opcode]))) {
+            continue;
+        }
+        // Bindings made by a child which does not match are discarded.
+        NSMutableDictionary* trial = [bindings mutableCopy];
+        if (matchPattern(childPattern, children[i], trial)) {
+            NSMutableArray* rest = [NSMutableArray arrayWithArray:children];
+            [rest removeObjectAtIndex:i];
+            trial[pattern.rest] = rest;
+            [bindings setDictionary:trial];
+            return YES;
+        }
+    }
+    return NO;
+}
+
+static MTExpression* instantiate(MTRewritePattern* replacement, NSDictionary* bindings) {
+    switch (replacement.kind) {
+        case kMTPatternBinding:
+            return bindings[replacement.name];
+
+        case kMTPatternNumber:
+            return replacement.value;
+
+        case kMTPatternOperator: {
+            NSMutableArray* args = [NSMutableArray arrayWithCapacity:replacement.children.count];
+            BOOL inserted = NO;
+            for (MTRewritePattern* child in replacement.children) {
+                if (child.kind == kMTPatternRest) {
+                    [args addObjectsFromArray:bindings[child.name]];
+                    inserted = YES;
+                } else {
+                    [args addObject:instantiate(child, bindings)];
+                }
+            }
+            NSCAssert(args.count > 0, @"No children for %c", replacement.operatorType);
+            if (inserted) {
+                if (args.count == 1) {
+                    return args[0];
+                }
+                return [MTOperator operatorWithType:replacement.operatorType args:args];
+            } else if (args.count == 1) {
+                return [MTOperator unaryOperatorWithType:replacement.operatorType arg:args[0] range:nil];
+            } else if (args.count == 2) {
+                return [MTOperator operatorWithType:replacement.operatorType args:args[0] :args[1]];
+            }
+            return [MTOperator operatorWithType:replacement.operatorType args:args];
+        }
+
+        case kMTPatternRest:
+            break;
+    }
+    NSCAssert(false, @"Unexpected replacement kind %d", replacement.kind);
+    return nil;
+}
+
+// Adds the names bound by the pattern to names, with YES for the rest of the children.
+static BOOL collectNames(MTRewritePattern* pattern, NSMutableDictionary* names) {
+    if (pattern.kind == kMTPatternBinding) {
+        if ([names[pattern.name] boolValue]) {
+            return NO;
+        }
+        names[pattern.name] = @NO;
+    } else if (pattern.kind == kMTPatternOperator) {
+        if (pattern.rest) {
+            if (names[pattern.rest]) {
+                return NO;
+            }
+            names[pattern.rest] = @YES;
+        }
+        for (MTRewritePattern* child in pattern.children) {
+            if (!collectNames(child, names)) {
+                return NO;
+            }
+        }
+    }
+    return YES;
+}
+
+// Checks that the replacement only uses names bound by the pattern.
+static BOOL checkNames(MTRewritePattern* replacement, NSDictionary* names) {
+    switch (replacement.kind) {
+        case kMTPatternBinding:
+            return names[replacement.name] && ![names[replacement.name] boolValue];
+        case kMTPatternRest:
+            return [names[replacement.name] boolValue];
+        case kMTPatternNumber:
+            return YES;
+        case kMTPatternOperator:
+            for (MTRewritePattern* child in replacement.children) {
+                if (!checkNames(child, names)) {
+                    return NO;
+                }
+            }
+            return YES;
+    }
+    return NO;
+}
+
+#pragma mark - MTRewriteRule
+
+@interface MTRewriteRule ()
+
+@property (nonatomic) MTRewritePattern* pattern;
+@property (nonatomic) MTRewritePattern* replacement;
+
+@end
+
+@implementation MTRewriteRule
+
++ (instancetype)ruleWithString:(NSString *)string
+{
+    MTRewriteRuleParser* parser = [[MTRewriteRuleParser alloc] initWithString:string];
+    MTRewritePattern* pattern = [parser parsePattern:NO];
+    if (!pattern) {
+        InfoLog(@"Invalid rule %@: %@", string, parser.error);
+        return nil;
+    }
+    if (pattern.kind != kMTPatternOperator) {
+        InfoLog(@"Invalid rule %@: The pattern should be an operator", string);
+        return nil;
+    }
+    if (![parser expectToken:@"=>"]) {
+        InfoLog(@"Invalid rule %@: %@", string, parser.error);
+        return nil;
+    }
+    MTRewritePattern* replacement = [parser parsePattern:YES];
+    if (!replacement) {
+        InfoLog(@"Invalid rule %@: %@", string, parser.error);
+        return nil;
+    }
+    if (!parser.isAtEnd) {
+        InfoLog(@"Invalid rule %@: Unexpected text after the replacement", string);
+        return nil;
+    }
+    NSMutableDictionary* names = [NSMutableDictionary dictionary];
+    if (!collectNames(pattern, names) || !checkNames(replacement, names)) {
+        InfoLog(@"Invalid rule %@: The names in the replacement do not match the pattern", string);
+        return nil;
+    }
+
+    MTRewriteRule* rule = [self new];
+    rule->_string = [string copy];
+    rule.pattern = pattern;
+    rule.replacement = replacement;
+    return rule;
+}
+
+- (NSString *)description
+{
+    return self.string;
+}
+
+@end
+
+#pragma mark - MTRewriteRuleSet
+
+@implementation MTRewriteRuleSet {
+    // The discrimination tree: a node is looked up by its opcode and then by the opcode of its first child for rules with
+    // children in order, or by the opcodes of all its children for rules matching any child. Each entry is the set of
+    // rules which can match as a bit mask of their indices.
+    uint64_t _firstChild[kMTOpcodeCount][kMTOpcodeCount];
+    uint64_t _anyChild[kMTOpcodeCount][kMTOpcodeCount];
+    // The identifier of a combined rule set.
+    NSString* _identifier;
+}
+
++ (NSArray *)rewriteRules
+{
+    return @[];
+}
+
++ (instancetype)ruleSetWithRules:(NSArray *)rules
+{
+    return [[self alloc] initWithRules:rules];
+}
+
++ (instancetype)ruleSetCombining:(NSArray *)ruleSets
+{
+    NSMutableArray* rules = [NSMutableArray array];
+    NSMutableArray* identifiers = [NSMutableArray arrayWithCapacity:ruleSets.count];
+    for (MTRewriteRuleSet* ruleSet in ruleSets) {
+        [rules addObjectsFromArray:ruleSet.rules];
+        [identifiers addObject:ruleSet.identifier];
+    }
+    MTRewriteRuleSet* combined = [MTRewriteRuleSet ruleSetWithRules:rules];
+    combined->_identifier = [identifiers componentsJoinedByString:@"+"];
+    return combined;
+}
+
+- (NSString *)identifier
+{
+    if (_identifier) {
+        return _identifier;
+    } else if ([self class] == [MTRewriteRuleSet class]) {
+        // A set created from a list of rules has no class of its own, so it is identified by its rules.
+        return [[_rules valueForKey:@"string"] componentsJoinedByString:@"; "];
+    }
+    return [super identifier];
+}
+
+- (id)init
+{
+    NSArray* strings = [[self class] rewriteRules];
+    NSMutableArray* rules = [NSMutableArray arrayWithCapacity:strings.count];
+    for (NSString* string in strings) {
+        MTRewriteRule* rule = [MTRewriteRule ruleWithString:string];
+        NSAssert(rule, @"Invalid rule %@ in %@", string, NSStringFromClass([self class]));
+        if (rule) {
+            [rules addObject:rule];
+        }
+    }
+    return [self initWithRules:rules];
+}
+
+- (instancetype) initWithRules:(NSArray*) rules
+{
+    self = [super init];
+    if (self) {
+        NSAssert(rules.count <= kMTMaxRewriteRules, @"Too many rules: %lu", (unsigned long) rules.count);
+        _rules = [rules copy];
+        for (NSUInteger i = 0; i < _rules.count && i < kMTMaxRewriteRules; i++) {
+            MTRewritePattern* pattern = [_rules[i] pattern];
+            MTRewritePattern* firstChild = pattern.children[0];
+            for (int head = 0; head < kMTOpcodeCount; head++) {
+                if (!(pattern.heads & (1 << head))) {
+                    continue;
+                }
+                for (int childHead = 0; childHead < kMTOpcodeCount; childHead++) {
+                    if (!(firstChild.heads & (1 << childHead))) {
+                        continue;
+                    }
+                    if (pattern.rest) {
+                        _anyChild[head][childHead] |= (1ull << i);
+                    } else {
+                        _firstChild[head][childHead] |= (1ull << i);
+                    }
+                }
+            }
+        }
+    }
+    return self;
+}
+
+- (MTExpression *)applyToTopLevelNode:(MTExpression *)expr withChildren:(NSArray *)args
+{
+    if (args.count == 0) {
+        return expr;
+    }
+    MTOpcode opcode = expr.opcode;
+    uint64_t candidates = _firstChild[opcode][[args[0] opcode]];
+    for (MTExpression* arg in args) {
+        candidates |= _anyChild[opcode][arg.opcode];
+    }
+
+    // Try the candidates in the order of the rules.
+    while (candidates) {
+        int index = __builtin_ctzll(candidates);
+        candidates &= candidates - 1;
+        MTRewriteRule* rule = _rules[index];
+        NSMutableDictionary* bindings = [NSMutableDictionary dictionary];
+        if (matchChildren(rule.pattern, args, bindings)) {
+            return instantiate(rule.replacement, bindings);
+        }
+    }
+    return expr;
+}
+
+@end
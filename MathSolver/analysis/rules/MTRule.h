@@ -17,9 +17,16 @@
 // create a rule
 + (instancetype) rule;
 
+// A name for the rule which is the same across runs, used to record which rules fire. Defaults to the class name.
+- (NSString*) identifier;
+
 // Does a recursive post-order traversal of the expression, applying the rule.
 - (MTExpression*) apply:(MTExpression*) expr;
 
+// Same as apply: but the children of a node are visited concurrently when at least two of them have minimumSize or more nodes.
+// The result is the same as that of apply:.
+- (MTExpression*) apply:(MTExpression*) expr concurrentlyAboveSize:(NSUInteger) minimumSize;
+
 // Apply the rule only to the top level node. Subclasses need to implement this method. The children already have the rule applied to them.
 - (MTExpression*) applyToTopLevelNode:(MTExpression *)expr withChildren:(NSArray*) args;
 
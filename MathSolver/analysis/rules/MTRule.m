@@ -10,6 +10,7 @@
 
 #import "MTRule.h"
 #import "MTExpression.h"
+#import "MTExpressionUtil.h"
 
 @implementation MTRule
 
@@ -17,18 +18,32 @@
     return [[self alloc] init];
 }
 
+- (NSString*) identifier
+{
+    return NSStringFromClass([self class]);
+}
+
 - (MTExpression*) apply:(MTExpression *)expr
 {
     // This does a post order traversal of the Expression tree.
     NSArray *args = expr.children;
     NSMutableArray* modifiedArgs = [NSMutableArray arrayWithCapacity:[args count]];
-    BOOL newExpressionNeeded = NO;
     for (MTExpression* child in args) {
-        MTExpression* modified = [self apply:child];
-        if (modified != child) {
+        [modifiedArgs addObject:[self apply:child]];
+    }
+    return [self applyToNode:expr withModifiedChildren:modifiedArgs];
+}
+
+// Applies the rule to the top level of expr once the rule has been applied to its children.
+- (MTExpression*) applyToNode:(MTExpression*) expr withModifiedChildren:(NSArray*) modifiedArgs
+{
+    NSArray *args = expr.children;
+    BOOL newExpressionNeeded = NO;
+    for (NSUInteger i = 0; i < args.count; i++) {
+        if (modifiedArgs[i] != args[i]) {
             newExpressionNeeded = YES;
+            break;
         }
-        [modifiedArgs addObject:modified];
     }
     
     MTExpression* updatedExpr = [self applyToTopLevelNode:expr withChildren:modifiedArgs];
@@ -39,12 +54,54 @@
         
         // currently only operators have children, but in the future we could have functions too.
         MTOperator *oper = (MTOperator *) expr;
-        return [MTOperator operatorWithType:oper.type args:modifiedArgs range:expr.range];
+        return [MTOperator operatorWithType:oper.type args:modifiedArgs];
     }
     
     return expr;
 }
 
+- (MTExpression*) apply:(MTExpression*) expr concurrentlyAboveSize:(NSUInteger) minimumSize
+{
+    return [self apply:expr size:[MTExpressionUtil sizeOfExpression:expr] concurrentlyAboveSize:minimumSize];
+}
+
+- (MTExpression*) apply:(MTExpression*) expr size:(NSUInteger) size concurrentlyAboveSize:(NSUInteger) minimumSize
+{
+    NSArray *args = expr.children;
+    if (args.count < 2 || size <= 2 * minimumSize) {
+        // At most one child can be large enough, so there is nothing to run concurrently below this node.
+        return [self apply:expr];
+    }
+    NSUInteger count = args.count;
+    NSUInteger* sizes = malloc(count * sizeof(NSUInteger));
+    NSUInteger largeChildren = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        sizes[i] = [MTExpressionUtil sizeOfExpression:args[i]];
+        if (sizes[i] >= minimumSize) {
+            largeChildren++;
+        }
+    }
+
+    NSMutableArray* modifiedArgs = [NSMutableArray arrayWithCapacity:count];
+    if (largeChildren < 2) {
+        for (NSUInteger i = 0; i < count; i++) {
+            [modifiedArgs addObject:[self apply:args[i] size:sizes[i] concurrentlyAboveSize:minimumSize]];
+        }
+    } else {
+        for (NSUInteger i = 0; i < count; i++) {
+            [modifiedArgs addObject:[NSNull null]];
+        }
+        dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+            MTExpression* modified = [self apply:args[i] size:sizes[i] concurrentlyAboveSize:minimumSize];
+            @synchronized(modifiedArgs) {
+                modifiedArgs[i] = modified;
+            }
+        });
+    }
+    free(sizes);
+    return [self applyToNode:expr withModifiedChildren:modifiedArgs];
+}
+
 - (MTExpression*) applyToTopLevelNode:(MTExpression *)expr withChildren:(NSArray *)args
 {
     @throw [NSException exceptionWithName:@"InternalException"
@@ -8,9 +8,9 @@
 //  MIT license. See the LICENSE file for details.
 //
 
-#import "MTRule.h"
+#import "MTRewriteRule.h"
 
 // Removes expressions multiplied by 0.
-@interface MTZeroRule : MTRule
+@interface MTZeroRule : MTRewriteRuleSet
 
 @end
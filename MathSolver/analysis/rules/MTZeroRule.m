@@ -9,22 +9,13 @@
 //
 
 #import "MTZeroRule.h"
-#import "MTExpression.h"
 
 @implementation MTZeroRule
 
-- (MTExpression*) applyToTopLevelNode:(MTExpression *)expr withChildren:(NSArray *)args
++ (NSArray*) rewriteRules
 {
     // Multiplication by 0 returns 0
-    if (expr.expressionType != kMTExpressionTypeOperator || ![expr equalsExpressionValue:kMTMultiplication]) {
-        return expr;
-    }
-    for (MTExpression *arg in args) {
-        if (arg.expressionType == kMTExpressionTypeNumber && [arg.expressionValue isEquivalent:[MTRational zero]]) {
-            return arg;
-        }
-    }    
-    return expr;
+    return @[ @"(* z:zero ...rest) => z" ];
 }
 
 @end
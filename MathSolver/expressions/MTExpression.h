@@ -25,6 +25,25 @@ typedef enum {
     kMTEquation,
 } MTMathEntityType;
 
+// The kind of an expression together with the type of an operator. Unlike expressionValue this does not box anything,
+// so it is the cheapest way to check for a particular operator.
+typedef enum {
+    kMTOpcodeNumber = 0,
+    kMTOpcodeVariable,
+    kMTOpcodeNull,
+    kMTOpcodeAddition,
+    kMTOpcodeSubtraction,
+    kMTOpcodeMultiplication,
+    kMTOpcodeDivision,
+    kMTOpcodeUnaryMinus,
+    // An operator of an unknown type
+    kMTOpcodeUnknownOperator,
+    kMTOpcodeCount
+} MTOpcode;
+
+// The opcode of an operator with the given type.
+MTOpcode MTOpcodeForOperatorType(char type);
+
 @protocol MTMathEntity <NSObject>
 
 - (NSString*) stringValue;
@@ -52,6 +71,7 @@ enum MTExpressionType {
 
 // The range in the original MTMathList that created it, that this expression denotes.
 // Note range is only present when the Expression is created by the parser. For subsequent manipulations range is not required and not maintained.
+// The ranges are kept by the parser (see MTInfixParser rangeOfExpression:) so that the expressions created by the rules do not carry one.
 @property (nonatomic, readonly) MTMathListRange* range;
 
 // Returns a copy of the expression with the given range.
@@ -68,6 +88,9 @@ enum MTExpressionType {
 
 - (enum MTExpressionType) expressionType;
 
+// The kind of the expression and the type of the operator.
+- (MTOpcode) opcode;
+
 - (id) expressionValue;
 
 // Returns true if the expression has the given value
@@ -108,6 +131,8 @@ enum MTExpressionType {
 @interface MTOperator : MTExpression
 
 @property (nonatomic, readonly) char type;
+// The number of nodes in the tree of this operator.
+@property (nonatomic, readonly) NSUInteger size;
 
 // binary
 +(id) operatorWithType:(char)type args:(MTExpression *)arg1 :(MTExpression *)arg2 range:(MTMathListRange*)range;
@@ -10,6 +10,8 @@
 
 #import "MTExpression.h"
 #import "MTExpressionUtil.h"
+#import "MTExpressionSerializer.h"
+#import "MTInfixParser.h"
 
 const char kMTUnaryMinus = '_';
 const char kMTSubtraction = '-';
@@ -17,14 +19,31 @@ const char kMTAddition = '+';
 const char kMTMultiplication = '*';
 const char kMTDivision = '/';
 
-#pragma mark - MTExpression
+MTOpcode MTOpcodeForOperatorType(char type) {
+    switch (type) {
+        case '+':
+            return kMTOpcodeAddition;
+        case '-':
+            return kMTOpcodeSubtraction;
+        case '*':
+            return kMTOpcodeMultiplication;
+        case '/':
+            return kMTOpcodeDivision;
+        case '_':
+            return kMTOpcodeUnaryMinus;
+        default:
+            return kMTOpcodeUnknownOperator;
+    }
+}
 
-@interface MTExpression ()
-@property (nonatomic) MTMathListRange* range;
-@end
+#pragma mark - MTExpression
 
 @implementation MTExpression
 
+- (MTMathListRange *)range
+{
+    return [MTInfixParser rangeOfExpression:self];
+}
 
 - (NSArray*) children
 {
@@ -64,6 +83,13 @@ const char kMTDivision = '/';
                                  userInfo:nil];
 }
 
+- (MTOpcode) opcode
+{
+    @throw [NSException exceptionWithName:@"InternalException"
+                                   reason:[NSString stringWithFormat:@"You must override %@ in a subclass", NSStringFromSelector(_cmd)]
+                                 userInfo:nil];
+}
+
 - (id) expressionValue
 {
     @throw [NSException exceptionWithName:@"InternalException"
@@ -135,7 +161,7 @@ const char kMTDivision = '/';
 +(id) numberWithValue:(MTRational*)value range:(MTMathListRange*)range
 {
     MTNumber* number = [self numberWithValue:value];
-    number.range = range;
+    [MTInfixParser setRange:range forExpression:number];
     return number;
 }
 
@@ -195,11 +221,21 @@ const char kMTDivision = '/';
     return kMTExpressionTypeNumber;
 }
 
+- (MTOpcode) opcode
+{
+    return kMTOpcodeNumber;
+}
+
 - (id) expressionValue
 {
     return self.value;
 }
 
+- (BOOL)equalsExpressionValue:(int)value
+{
+    return [[MTRational rationalWithNumber:value] isEquivalent:self.value];
+}
+
 - (BOOL)isExpressionValueEqualToNumber:(NSNumber *)number
 {
     // convert to a rational before comparing
@@ -228,7 +264,7 @@ const char kMTDivision = '/';
 +(id) variableWithName:(char)name range:(MTMathListRange*)range
 {
     MTVariable* var = [self variableWithName:name];
-    var.range = range;
+    [MTInfixParser setRange:range forExpression:var];
     return var;
 }
 
@@ -285,11 +321,21 @@ const char kMTDivision = '/';
     return kMTExpressionTypeVariable;
 }
 
+- (MTOpcode) opcode
+{
+    return kMTOpcodeVariable;
+}
+
 - (id) expressionValue
 {
     return [NSNumber numberWithChar:self.name];
 }
 
+- (BOOL)equalsExpressionValue:(int)value
+{
+    return self.name == value;
+}
+
 - (MTExpression *)expressionWithRange:(MTMathListRange *)range
 {
     return [MTVariable variableWithName:self.name range:range];
@@ -301,6 +347,9 @@ const char kMTDivision = '/';
 
 @implementation MTOperator {
     NSArray *_args;
+    NSUInteger _hash;
+    NSUInteger _size;
+    MTOpcode _opcode;
 }
 
 - (void) setArgs:(NSArray *) args {
@@ -313,44 +362,21 @@ const char kMTDivision = '/';
 }
 
 - (NSString*) stringValue {
-    NSMutableString* str = [NSMutableString stringWithString:@"("];
-    if (_args.count == 1) {
-        // Unary case is different
-        MTExpression* expr = [_args objectAtIndex:0];
-        [str appendFormat:@"%c %@)", _type, expr.stringValue];
-        return str;
-    }
-    
-    for (int i = 0; i < _args.count; ++i) {
-        MTExpression* expr = [_args objectAtIndex:i];
-        [str appendString:expr.stringValue];
-        if (i != _args.count - 1) {
-            [str appendFormat:@" %c ", _type];
-        }
-    }
-    [str appendString:@")"];
-    return str;
+    return [MTExpressionSerializer stringForEntity:self];
 }
 
 +(id) operatorWithType:(char)type args:(MTExpression *)arg1 :(MTExpression *)arg2
 {
-    MTMathListRange* opRange = nil;
-    if (arg1.range && arg2.range) {
-        opRange = [arg1.range unionRange:arg2.range];
-    } else if (arg1.range) {
-        opRange = arg1.range;
-    } else if (arg2.range) {
-        opRange = arg2.range;
-    }
-    return [self operatorWithType:type args:arg1 :arg2 range:opRange];
+    return [self operatorWithType:type args:arg1 :arg2 range:nil];
 }
 
 +(id) operatorWithType:(char)type args:(MTExpression *)arg1 :(MTExpression *)arg2 range:(MTMathListRange*)range
 {
     MTOperator* op = [[MTOperator alloc] init];
     op->_type = type;
+    op->_opcode = MTOpcodeForOperatorType(type);
     [op setArgs:@[arg1, arg2]];
-    op.range = range;
+    [MTInfixParser setRange:range forExpression:op];
     return op;
 }
 
@@ -358,8 +384,9 @@ const char kMTDivision = '/';
 {
     MTOperator* op = [[MTOperator alloc] init];
     op->_type = type;
+    op->_opcode = MTOpcodeForOperatorType(type);
     [op setArgs:@[arg]];
-    op.range = range;
+    [MTInfixParser setRange:range forExpression:op];
     return op;
 }
 
@@ -372,7 +399,8 @@ const char kMTDivision = '/';
     MTOperator* op = [[MTOperator alloc] init];
     assert([args count] > 1);   // no unary operators allowed.
     op->_type = type;
-    op.range = range;
+    op->_opcode = MTOpcodeForOperatorType(type);
+    [MTInfixParser setRange:range forExpression:op];
     [op setArgs:args];
     return op;
 }
@@ -415,8 +443,30 @@ const char kMTDivision = '/';
 
 - (NSUInteger) hash
 {
-    const int prime = 31;
-    return prime * self.type + [_args hash];
+    // The hash of an NSArray is just its count, so combine the hashes of the children instead.
+    // Operators are immutable, so the hash is only computed once.
+    if (!_hash) {
+        const int prime = 31;
+        NSUInteger hash = self.type;
+        for (MTExpression* arg in _args) {
+            hash = prime * hash + arg.hash;
+        }
+        _hash = hash;
+    }
+    return _hash;
+}
+
+- (NSUInteger) size
+{
+    // Operators are immutable, so the size is only computed once.
+    if (!_size) {
+        NSUInteger size = 1;
+        for (MTExpression* arg in _args) {
+            size += (arg.expressionType == kMTExpressionTypeOperator) ? ((MTOperator*) arg).size : 1;
+        }
+        _size = size;
+    }
+    return _size;
 }
 
 - (NSUInteger) degree
@@ -442,17 +492,24 @@ const char kMTDivision = '/';
     return kMTExpressionTypeOperator;
 }
 
+- (MTOpcode) opcode
+{
+    return _opcode;
+}
+
 - (id) expressionValue
 {
     return [NSNumber numberWithChar:self.type];
 }
 
+- (BOOL)equalsExpressionValue:(int)value
+{
+    return self.type == value;
+}
+
 - (BOOL) isEqualUptoRearrangement:(MTExpression *)expr
 {
-    if (self.expressionType != expr.expressionType) {
-        return false;
-    }
-    if (![self.expressionValue isEqual:expr.expressionValue]) {
+    if (expr.expressionType != kMTExpressionTypeOperator || ((MTOperator*) expr).type != self.type) {
         return false;
     }
     
@@ -461,10 +518,7 @@ const char kMTDivision = '/';
 
 - (BOOL)isEqualUptoRearrangementRecursive:(MTExpression *)expr
 {
-    if (self.expressionType != expr.expressionType) {
-        return false;
-    }
-    if (![self.expressionValue isEqual:expr.expressionValue]) {
+    if (expr.expressionType != kMTExpressionTypeOperator || ((MTOperator*) expr).type != self.type) {
         return false;
     }
     
@@ -539,6 +593,16 @@ const char kMTDivision = '/';
     return kMTExpressionTypeNull;
 }
 
+- (MTOpcode) opcode
+{
+    return kMTOpcodeNull;
+}
+
+- (BOOL)equalsExpressionValue:(int)value
+{
+    return NO;
+}
+
 - (id) expressionValue
 {
     return [NSNull null];
@@ -567,7 +631,7 @@ const char kMTDivision = '/';
 
 - (NSString *)stringValue
 {
-    return [NSString stringWithFormat:@"%@ %c %@", _lhs.stringValue, _relation, _rhs.stringValue];
+    return [MTExpressionSerializer stringForEntity:self];
 }
 
 - (NSString*) description
@@ -0,0 +1,34 @@
+//
+//  MTExpressionSerializer.h
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <Foundation/Foundation.h>
+#import "MTExpression.h"
+
+@class MTMathList;
+
+// Converts expressions and equations to text, LaTeX or an MTMathList.
+// The expression tree is walked iteratively with an explicit stack and all output is written into a single buffer,
+// so the cost is linear in the size of the expression and no intermediate strings are created for subexpressions.
+@interface MTExpressionSerializer : NSObject
+
+// Returns the same string as stringValue, e.g. ((2 * x) + -3)
++ (NSString*) stringForEntity:(id<MTMathEntity>) entity;
+
+// Appends the stringValue of the entity to the given string.
++ (void) appendEntity:(id<MTMathEntity>) entity toString:(NSMutableString*) str;
+
+// Returns LaTeX for displaying the entity, e.g. 2x + (-3). Parsing the LaTeX gives back an equivalent entity.
++ (NSString*) latexForEntity:(id<MTMathEntity>) entity;
+
+// Returns an MTMathList for displaying the entity. This is the same as building the list from the LaTeX above
+// but does not go through LaTeX.
++ (MTMathList*) mathListForEntity:(id<MTMathEntity>) entity;
+
+@end
@@ -0,0 +1,473 @@
+//
+//  MTExpressionSerializer.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import "MTExpressionSerializer.h"
+#import "MTMathList.h"
+
+#pragma mark - Stack
+
+// A node being visited. The expressions are retained by the tree being serialized, so they are not retained here.
+typedef struct {
+    __unsafe_unretained MTExpression* expr;
+    __unsafe_unretained NSArray* children;
+    // The index of the next child to visit.
+    NSUInteger next;
+    // If the node needs to be surrounded by parenthesis (only used for display).
+    BOOL parenthesize;
+} MTSerializerFrame;
+
+typedef struct {
+    MTSerializerFrame* frames;
+    NSUInteger count;
+    NSUInteger capacity;
+} MTSerializerStack;
+
+static void stackPush(MTSerializerStack* stack, MTExpression* expr, BOOL parenthesize) {
+    if (stack->count == stack->capacity) {
+        stack->capacity = (stack->capacity) ? stack->capacity * 2 : 16;
+        stack->frames = realloc(stack->frames, stack->capacity * sizeof(MTSerializerFrame));
+    }
+    MTSerializerFrame* frame = &stack->frames[stack->count++];
+    frame->expr = expr;
+    frame->children = expr.children;
+    frame->next = 0;
+    frame->parenthesize = parenthesize;
+}
+
+#pragma mark - Text
+
+static void appendRational(NSMutableString* str, MTRational* value) {
+    if (value.format == kMTRationalFormatDecimal && value.denominator != 1) {
+        [str appendString:value.description];
+    } else if (value.format == kMTRationalFormatWhole || value.denominator == 1) {
+        [str appendFormat:@"%ld", (long)value.numerator];
+    } else {
+        [str appendFormat:@"%ld/%ld", (long)value.numerator, (long)value.denominator];
+    }
+}
+
+static void appendExpression(NSMutableString* str, MTExpression* root) {
+    MTSerializerStack stack = { NULL, 0, 0 };
+    stackPush(&stack, root, NO);
+    while (stack.count > 0) {
+        MTSerializerFrame* frame = &stack.frames[stack.count - 1];
+        MTExpression* expr = frame->expr;
+        switch (expr.expressionType) {
+            case kMTExpressionTypeNumber:
+                appendRational(str, ((MTNumber*) expr).value);
+                stack.count--;
+                continue;
+
+            case kMTExpressionTypeVariable:
+                [str appendFormat:@"%c", ((MTVariable*) expr).name];
+                stack.count--;
+                continue;
+
+            case kMTExpressionTypeNull:
+                [str appendString:@"(null)"];
+                stack.count--;
+                continue;
+
+            case kMTExpressionTypeOperator:
+                break;
+        }
+        char type = ((MTOperator*) expr).type;
+        NSArray* children = frame->children;
+        if (frame->next == 0) {
+            [str appendString:@"("];
+            if (children.count == 1) {
+                // Unary case is different
+                [str appendFormat:@"%c ", type];
+            }
+        } else if (frame->next < children.count) {
+            [str appendFormat:@" %c ", type];
+        }
+        if (frame->next < children.count) {
+            MTExpression* child = children[frame->next++];
+            // frame is invalid after the push.
+            stackPush(&stack, child, NO);
+        } else {
+            [str appendString:@")"];
+            stack.count--;
+        }
+    }
+    free(stack.frames);
+}
+
+#pragma mark - Display
+
+// Receives the tokens for displaying an expression.
+@protocol MTDisplayWriter <NSObject>
+
+- (void) number:(MTRational*) value;
+- (void) variable:(char) name;
+- (void) null;
+// One of + - * = and unary -
+- (void) operator:(char) type;
+- (void) openParen;
+- (void) closeParen;
+- (void) beginFraction;
+- (void) fractionDenominator;
+- (void) endFraction;
+
+@end
+
+// Writes LaTeX.
+@interface MTLatexWriter : NSObject<MTDisplayWriter>
+
+@property (nonatomic, readonly) NSMutableString* latex;
+
+@end
+
+@implementation MTLatexWriter
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        _latex = [NSMutableString string];
+    }
+    return self;
+}
+
+- (void) number:(MTRational*) value
+{
+    if (value.isNegative) {
+        [_latex appendString:@"-"];
+        value = value.absoluteValue;
+    }
+    if (value.format == kMTRationalFormatDecimal || value.format == kMTRationalFormatWhole || value.denominator == 1) {
+        appendRational(_latex, value);
+    } else {
+        [_latex appendFormat:@"\\frac{%ld}{%ld}", (long)value.numerator, (long)value.denominator];
+    }
+}
+
+- (void) variable:(char) name
+{
+    [_latex appendFormat:@"%c", name];
+}
+
+- (void) null
+{
+    [_latex appendString:@"\\emptyset"];
+}
+
+- (void) operator:(char) type
+{
+    switch (type) {
+        case '*':
+            [_latex appendString:@" \\times "];
+            break;
+        case '_':
+            [_latex appendString:@"-"];
+            break;
+        default:
+            [_latex appendFormat:@" %c ", type];
+            break;
+    }
+}
+
+- (void) openParen
+{
+    [_latex appendString:@"("];
+}
+
+- (void) closeParen
+{
+    [_latex appendString:@")"];
+}
+
+- (void) beginFraction
+{
+    [_latex appendString:@"\\frac{"];
+}
+
+- (void) fractionDenominator
+{
+    [_latex appendString:@"}{"];
+}
+
+- (void) endFraction
+{
+    [_latex appendString:@"}"];
+}
+
+@end
+
+// Builds an MTMathList.
+@interface MTMathListWriter : NSObject<MTDisplayWriter>
+
+@property (nonatomic, readonly) MTMathList* mathList;
+
+@end
+
+@implementation MTMathListWriter {
+    // The list atoms are added to, the lists of enclosing fractions are below it.
+    NSMutableArray* _lists;
+    // The fractions being built.
+    NSMutableArray* _fractions;
+}
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        _mathList = [MTMathList new];
+        _lists = [NSMutableArray arrayWithObject:_mathList];
+        _fractions = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void) addAtomWithType:(MTMathAtomType) type value:(NSString*) value
+{
+    MTMathList* current = _lists.lastObject;
+    [current addAtom:[MTMathAtom atomWithType:type value:value]];
+}
+
+// Adds an atom for each digit as the LaTeX parser does.
+- (void) addDigits:(NSString*) digits toList:(MTMathList*) list
+{
+    for (NSUInteger i = 0; i < digits.length; i++) {
+        [list addAtom:[MTMathAtom atomWithType:kMTMathAtomNumber value:[digits substringWithRange:NSMakeRange(i, 1)]]];
+    }
+}
+
+- (void) number:(MTRational*) value
+{
+    if (value.isNegative) {
+        [self addAtomWithType:kMTMathAtomBinaryOperator value:@"−"];
+        value = value.absoluteValue;
+    }
+    MTMathList* current = _lists.lastObject;
+    if (value.format == kMTRationalFormatDecimal || value.format == kMTRationalFormatWhole || value.denominator == 1) {
+        NSMutableString* digits = [NSMutableString string];
+        appendRational(digits, value);
+        [self addDigits:digits toList:current];
+    } else {
+        MTFraction* frac = [MTFraction new];
+        frac.numerator = [MTMathList new];
+        frac.denominator = [MTMathList new];
+        [self addDigits:[NSString stringWithFormat:@"%ld", (long)value.numerator] toList:frac.numerator];
+        [self addDigits:[NSString stringWithFormat:@"%ld", (long)value.denominator] toList:frac.denominator];
+        [current addAtom:frac];
+    }
+}
+
+- (void) variable:(char) name
+{
+    [self addAtomWithType:kMTMathAtomVariable value:[NSString stringWithFormat:@"%c", name]];
+}
+
+- (void) null
+{
+    [self addAtomWithType:kMTMathAtomOrdinary value:@"∅"];
+}
+
+- (void) operator:(char) type
+{
+    switch (type) {
+        case '*':
+            [self addAtomWithType:kMTMathAtomBinaryOperator value:@"×"];
+            break;
+        case '-':
+        case '_':
+            // The parser treats a minus at the start of a list or after an operator as unary.
+            [self addAtomWithType:kMTMathAtomBinaryOperator value:@"−"];
+            break;
+        case '=':
+            [self addAtomWithType:kMTMathAtomRelation value:@"="];
+            break;
+        default:
+            [self addAtomWithType:kMTMathAtomBinaryOperator value:[NSString stringWithFormat:@"%c", type]];
+            break;
+    }
+}
+
+- (void) openParen
+{
+    [self addAtomWithType:kMTMathAtomOpen value:@"("];
+}
+
+- (void) closeParen
+{
+    [self addAtomWithType:kMTMathAtomClose value:@")"];
+}
+
+- (void) beginFraction
+{
+    MTFraction* frac = [MTFraction new];
+    frac.numerator = [MTMathList new];
+    frac.denominator = [MTMathList new];
+    [(MTMathList*)_lists.lastObject addAtom:frac];
+    [_fractions addObject:frac];
+    [_lists addObject:frac.numerator];
+}
+
+- (void) fractionDenominator
+{
+    MTFraction* frac = _fractions.lastObject;
+    [_lists removeLastObject];
+    [_lists addObject:frac.denominator];
+}
+
+- (void) endFraction
+{
+    [_fractions removeLastObject];
+    [_lists removeLastObject];
+}
+
+@end
+
+static BOOL isOperator(MTExpression* expr, char type) {
+    return expr.expressionType == kMTExpressionTypeOperator && ((MTOperator*) expr).type == type;
+}
+
+// Whether the child at the given index of parent needs parenthesis to be displayed unambiguously.
+static BOOL needsParenthesis(MTExpression* child, MTOperator* parent, NSUInteger index) {
+    char type = parent.type;
+    if (type == kMTDivision) {
+        // The numerator and denominator of a fraction are already grouped.
+        return NO;
+    }
+    if (child.expressionType == kMTExpressionTypeNumber && [((MTNumber*) child).value isNegative]) {
+        // -ve numbers are only written without parenthesis at the start.
+        return index > 0 || type == kMTUnaryMinus;
+    }
+    if (isOperator(child, kMTAddition) || isOperator(child, kMTSubtraction)) {
+        return type == kMTMultiplication || type == kMTUnaryMinus || (type == kMTSubtraction && index > 0);
+    }
+    if (isOperator(child, kMTUnaryMinus)) {
+        return index > 0 || type == kMTUnaryMinus;
+    }
+    return NO;
+}
+
+// Whether the multiplication sign between the factors can be left out, e.g. 2x or x(y + 1).
+static BOOL isImplicitMultiplication(MTExpression* factor) {
+    return factor.expressionType == kMTExpressionTypeVariable || isOperator(factor, kMTAddition) || isOperator(factor, kMTSubtraction);
+}
+
+static void writeExpression(id<MTDisplayWriter> writer, MTExpression* root) {
+    MTSerializerStack stack = { NULL, 0, 0 };
+    stackPush(&stack, root, NO);
+    while (stack.count > 0) {
+        MTSerializerFrame* frame = &stack.frames[stack.count - 1];
+        MTExpression* expr = frame->expr;
+        if (expr.expressionType != kMTExpressionTypeOperator) {
+            if (frame->parenthesize) {
+                [writer openParen];
+            }
+            switch (expr.expressionType) {
+                case kMTExpressionTypeNumber:
+                    [writer number:((MTNumber*) expr).value];
+                    break;
+                case kMTExpressionTypeVariable:
+                    [writer variable:((MTVariable*) expr).name];
+                    break;
+                case kMTExpressionTypeNull:
+                case kMTExpressionTypeOperator:
+                    [writer null];
+                    break;
+            }
+            if (frame->parenthesize) {
+                [writer closeParen];
+            }
+            stack.count--;
+            continue;
+        }
+
+        MTOperator* oper = (MTOperator*) expr;
+        NSArray* children = frame->children;
+        NSUInteger next = frame->next;
+        if (next == 0) {
+            if (frame->parenthesize) {
+                [writer openParen];
+            }
+            if (oper.type == kMTDivision) {
+                [writer beginFraction];
+            } else if (children.count == 1) {
+                [writer operator:oper.type];
+            }
+        } else if (next < children.count) {
+            if (oper.type == kMTDivision) {
+                [writer fractionDenominator];
+            } else if (oper.type != kMTMultiplication || !isImplicitMultiplication(children[next])) {
+                [writer operator:oper.type];
+            }
+        }
+        if (next < children.count) {
+            MTExpression* child = children[next];
+            frame->next++;
+            // frame is invalid after the push.
+            stackPush(&stack, child, needsParenthesis(child, oper, next));
+        } else {
+            if (oper.type == kMTDivision) {
+                [writer endFraction];
+            }
+            if (frame->parenthesize) {
+                [writer closeParen];
+            }
+            stack.count--;
+        }
+    }
+    free(stack.frames);
+}
+
+static void writeEntity(id<MTDisplayWriter> writer, id<MTMathEntity> entity) {
+    if (entity.entityType == kMTEquation) {
+        MTEquation* eq = (MTEquation*) entity;
+        writeExpression(writer, eq.lhs);
+        [writer operator:eq.relation];
+        writeExpression(writer, eq.rhs);
+    } else {
+        writeExpression(writer, (MTExpression*) entity);
+    }
+}
+
+#pragma mark - MTExpressionSerializer
+
+@implementation MTExpressionSerializer
+
++ (NSString *)stringForEntity:(id<MTMathEntity>)entity
+{
+    NSMutableString* str = [NSMutableString string];
+    [self appendEntity:entity toString:str];
+    return str;
+}
+
++ (void)appendEntity:(id<MTMathEntity>)entity toString:(NSMutableString *)str
+{
+    if (entity.entityType == kMTEquation) {
+        MTEquation* eq = (MTEquation*) entity;
+        appendExpression(str, eq.lhs);
+        [str appendFormat:@" %c ", eq.relation];
+        appendExpression(str, eq.rhs);
+    } else {
+        appendExpression(str, (MTExpression*) entity);
+    }
+}
+
++ (NSString *)latexForEntity:(id<MTMathEntity>)entity
+{
+    MTLatexWriter* writer = [MTLatexWriter new];
+    writeEntity(writer, entity);
+    return writer.latex;
+}
+
++ (MTMathList *)mathListForEntity:(id<MTMathEntity>)entity
+{
+    MTMathListWriter* writer = [MTMathListWriter new];
+    writeEntity(writer, entity);
+    return writer.mathList;
+}
+
+@end
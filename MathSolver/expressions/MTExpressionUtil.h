@@ -57,9 +57,18 @@
 // Return a set of all the variables in the expression
 + (NSSet*) getVariablesInExpression:(MTExpression*) expr;
 
+// Returns the number of nodes in the expression tree.
++ (NSUInteger) sizeOfExpression:(MTExpression*) expr;
+
 // Returns true if expression expr contains the variable var.
 + (BOOL) expression:(MTExpression*)expr containsVariable:(MTVariable*) var;
 
+// If the expression is a polynomial of degree at most maxDegree in at most one variable, returns the coefficients (MTRational) indexed
+// by degree without any trailing zeros, and the variable in var (nil if there is none). Otherwise returns nil.
+// The expression may only contain numbers, a single variable, +, -, unary minus, * and division by a non-zero number.
+// The polynomial 0 has no coefficients.
++ (NSArray*) coefficientsOfPolynomial:(MTExpression*) expr maxDegree:(NSUInteger) maxDegree variable:(MTVariable**) var;
+
 // Get the leading term for an expression in normal form.
 + (MTExpression*) getLeadingTerm:(MTExpression*) expr;
 
@@ -18,24 +18,140 @@ static MTCalculateRule *_calc;
 static MTIdentityRule *_identity;
 
 static MTRule* getCalculateRule() {
-    if (_calc == nil) {
+    static dispatch_once_t onceToken = 0;
+    dispatch_once(&onceToken, ^{
         _calc = [MTCalculateRule rule];
-    }
+    });
     return _calc;
 }
 
 static MTRule* getIdentityRule() {
-    if (_identity == nil) {
+    static dispatch_once_t onceToken = 0;
+    dispatch_once(&onceToken, ^{
         _identity = [MTIdentityRule rule];
-    }
+    });
     return _identity;
 }
 
+// Removes the trailing zero coefficients, i.e. the zero coefficients of the highest degrees.
+static NSArray* trimCoefficients(NSMutableArray* coefficients) {
+    while (coefficients.count > 0 && [coefficients.lastObject isZero]) {
+        [coefficients removeLastObject];
+    }
+    return coefficients;
+}
+
+static NSArray* addCoefficients(NSArray* c1, NSArray* c2) {
+    NSMutableArray* sum = [NSMutableArray arrayWithCapacity:MAX(c1.count, c2.count)];
+    for (NSUInteger i = 0; i < MAX(c1.count, c2.count); i++) {
+        if (i >= c1.count) {
+            [sum addObject:c2[i]];
+        } else if (i >= c2.count) {
+            [sum addObject:c1[i]];
+        } else {
+            [sum addObject:[c1[i] add:c2[i]]];
+        }
+    }
+    return trimCoefficients(sum);
+}
+
+static NSArray* scaleCoefficients(NSArray* coefficients, MTRational* factor) {
+    NSMutableArray* scaled = [NSMutableArray arrayWithCapacity:coefficients.count];
+    for (MTRational* c in coefficients) {
+        [scaled addObject:[c multiply:factor]];
+    }
+    return trimCoefficients(scaled);
+}
+
+// Returns nil if the degree of the product is more than maxDegree.
+static NSArray* multiplyCoefficients(NSArray* c1, NSArray* c2, NSUInteger maxDegree) {
+    if (c1.count == 0 || c2.count == 0) {
+        return @[];
+    }
+    NSUInteger count = c1.count + c2.count - 1;
+    if (count > maxDegree + 1) {
+        return nil;
+    }
+    NSMutableArray* product = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [product addObject:[MTRational zero]];
+    }
+    for (NSUInteger i = 0; i < c1.count; i++) {
+        for (NSUInteger j = 0; j < c2.count; j++) {
+            product[i + j] = [product[i + j] add:[c1[i] multiply:c2[j]]];
+        }
+    }
+    return trimCoefficients(product);
+}
+
+static NSArray* polynomialCoefficients(MTExpression* expr, NSUInteger maxDegree, MTVariable* __strong * var) {
+    switch (expr.expressionType) {
+        case kMTExpressionTypeNumber: {
+            NSMutableArray* coefficients = [NSMutableArray arrayWithObject:expr.expressionValue];
+            return trimCoefficients(coefficients);
+        }
+
+        case kMTExpressionTypeVariable:
+            if (*var && ![*var isEqual:expr]) {
+                // more than one variable
+                return nil;
+            }
+            *var = (MTVariable*) expr;
+            return (maxDegree >= 1) ? @[[MTRational zero], [MTRational one]] : nil;
+
+        case kMTExpressionTypeOperator: {
+            MTOperator* oper = (MTOperator*) expr;
+            NSMutableArray* childCoefficients = [NSMutableArray arrayWithCapacity:oper.children.count];
+            for (MTExpression* child in oper.children) {
+                NSArray* coefficients = polynomialCoefficients(child, maxDegree, var);
+                if (!coefficients) {
+                    return nil;
+                }
+                [childCoefficients addObject:coefficients];
+            }
+            if (oper.type == kMTAddition) {
+                NSArray* sum = @[];
+                for (NSArray* coefficients in childCoefficients) {
+                    sum = addCoefficients(sum, coefficients);
+                }
+                return sum;
+            } else if (oper.type == kMTSubtraction) {
+                NSCAssert(childCoefficients.count == 2, @"Subtraction should have 2 arguments");
+                return addCoefficients(childCoefficients[0], scaleCoefficients(childCoefficients[1], [MTRational one].negation));
+            } else if (oper.type == kMTUnaryMinus) {
+                NSCAssert(childCoefficients.count == 1, @"Unary minus should have 1 argument");
+                return scaleCoefficients(childCoefficients[0], [MTRational one].negation);
+            } else if (oper.type == kMTMultiplication) {
+                NSArray* product = @[[MTRational one]];
+                for (NSArray* coefficients in childCoefficients) {
+                    product = multiplyCoefficients(product, coefficients, maxDegree);
+                    if (!product) {
+                        return nil;
+                    }
+                }
+                return product;
+            } else if (oper.type == kMTDivision) {
+                NSCAssert(childCoefficients.count == 2, @"Division should have 2 arguments");
+                NSArray* divisor = childCoefficients[1];
+                if (divisor.count != 1) {
+                    // Division by 0 or by a polynomial.
+                    return nil;
+                }
+                return scaleCoefficients(childCoefficients[0], [divisor[0] reciprocal]);
+            }
+            return nil;
+        }
+
+        case kMTExpressionTypeNull:
+            return nil;
+    }
+}
+
 @implementation MTExpressionUtil
 
 + (MTOperator*) negate:(MTExpression *)expr
 {
-    return [MTOperator operatorWithType:kMTMultiplication args:[MTNumber numberWithValue:[MTRational one].negation range:expr.range] :expr range:expr.range];
+    return [MTOperator operatorWithType:kMTMultiplication args:[MTNumber numberWithValue:[MTRational one].negation] :expr];
 }
 
 + (BOOL) expression: (MTExpression*) expr getCoefficent:(MTRational**) c variables:(NSArray**) vars
@@ -71,10 +187,10 @@ static MTRule* getIdentityRule() {
             MTNumber *coefficient = nil;
             NSMutableArray* mutableVars = [NSMutableArray array];
             for (MTExpression* childArg in oper.children) {
-                if ([childArg isKindOfClass:[MTNumber class]] && !numberFound) {
+                if (childArg.opcode == kMTOpcodeNumber && !numberFound) {
                     numberFound = YES;
                     coefficient = (MTNumber *)childArg;
-                } else if ([childArg isKindOfClass:[MTVariable class]]) {
+                } else if (childArg.opcode == kMTOpcodeVariable) {
                     [mutableVars addObject:childArg];
                 } else {
                     // arg is notof the form we are looking for.
@@ -234,19 +350,6 @@ static MTRule* getIdentityRule() {
     return nil;
 }
 
-+ (MTMathListRange*) unionedRange:(NSArray*) exprs
-{
-    NSMutableArray* ranges = [NSMutableArray arrayWithCapacity:exprs.count];
-    for (MTExpression* expr in exprs) {
-        if (expr.range) {
-            [ranges addObject:expr.range];
-        } else {
-            return nil;
-        }
-    }
-    return [MTMathListRange unionRanges:ranges];
-}
-
 + (MTExpression*) combineExpressions:(NSArray*) exprs withOperatorType:(char) operatorType
 {
     if (exprs.count == 0) {
@@ -254,7 +357,7 @@ static MTRule* getIdentityRule() {
     } else if (exprs.count == 1) {
         return exprs[0];
     } else {
-        return [MTOperator operatorWithType:operatorType args:exprs range:[self unionedRange:exprs]];
+        return [MTOperator operatorWithType:operatorType args:exprs];
     }
 }
 
@@ -294,7 +397,7 @@ static MTRule* getIdentityRule() {
             *difference = childrenWithoutExpr;
         }
         return true;
-    } else if (expr.expressionType == kMTExpressionTypeOperator && [expr equalsExpressionValue:oper.type]) {
+    } else if (expr.opcode == oper.opcode) {
         NSArray *added;
         if([MTExpressionUtil diffOperator:oper with:(MTOperator*) expr removedChildren:difference addedChildren:&added]) {
             NSParameterAssert(added);
@@ -309,6 +412,16 @@ static MTRule* getIdentityRule() {
 }
 
 
++ (NSArray*) coefficientsOfPolynomial:(MTExpression*) expr maxDegree:(NSUInteger) maxDegree variable:(MTVariable**) var
+{
+    MTVariable* variable = nil;
+    NSArray* coefficients = polynomialCoefficients(expr, maxDegree, &variable);
+    if (var) {
+        *var = variable;
+    }
+    return coefficients;
+}
+
 + (MTExpression*) getLeadingTerm:(MTExpression*) expr
 {
     if (expr.expressionType != kMTExpressionTypeOperator) {
@@ -316,10 +429,10 @@ static MTRule* getIdentityRule() {
     }
     
     // operator
-    if ([expr equalsExpressionValue:kMTMultiplication]) {
+    if (expr.opcode == kMTOpcodeMultiplication) {
         // This is the leading term, eg. 5x
         return expr;
-    } else if ([expr equalsExpressionValue:kMTAddition]) {
+    } else if (expr.opcode == kMTOpcodeAddition) {
         // first child
         return expr.children[0];
     } else {
@@ -353,19 +466,25 @@ static MTRule* getIdentityRule() {
     }
 }
 
++ (NSUInteger) sizeOfExpression:(MTExpression*) expr
+{
+    // Only operators have children.
+    return (expr.expressionType == kMTExpressionTypeOperator) ? ((MTOperator*) expr).size : 1;
+}
+
 + (BOOL) isDivision:(MTExpression*) expr
 {
-    return expr.expressionType == kMTExpressionTypeOperator && [expr equalsExpressionValue:kMTDivision];
+    return expr.opcode == kMTOpcodeDivision;
 }
 
 + (BOOL) isMultiplication:(MTExpression*) expr
 {
-    return expr.expressionType == kMTExpressionTypeOperator && [expr equalsExpressionValue:kMTMultiplication];
+    return expr.opcode == kMTOpcodeMultiplication;
 }
 
 + (BOOL) isAddition:(MTExpression *)expr
 {
-    return expr.expressionType == kMTExpressionTypeOperator && [expr equalsExpressionValue:kMTAddition];
+    return expr.opcode == kMTOpcodeAddition;
 }
 
 @end
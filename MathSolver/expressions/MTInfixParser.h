@@ -33,6 +33,13 @@ FOUNDATION_EXPORT NSString *const MTParseErrorOffset;
 - (MTExpression*) parseToExpressionFromMathList:(MTMathList*) mathList;
 - (MTEquation*) parseToEquationFromMathList:(MTMathList*) mathList;
 
+// The range in the math list of an expression created by a parser. nil for the expressions created in any other way, e.g.
+// by the rules. The ranges are kept in a table owned by the parser instead of in every expression.
++ (MTMathListRange*) rangeOfExpression:(MTExpression*) expr;
+
+// Records the range of an expression. Only used when creating the expressions of a parse.
++ (void) setRange:(MTMathListRange*) range forExpression:(MTExpression*) expr;
+
 // Returns true if the parsing has an error.
 - (BOOL) hasError;
 
@@ -14,6 +14,8 @@
 #import "MTSymbol.h"
 #import "MTMathList.h"
 #import "MTMathListIndex.h"
+#import "MTMathListBuilder.h"
+#import "MTTrace.h"
 
 // Returns the precedence of different supported operators
 static int precedence(char op) {
@@ -31,6 +33,18 @@ static int precedence(char op) {
     }
 }
 
+// expression -> range of the expressions created by the parser. Compared by pointer since equal expressions may come from
+// different places in the math list.
+static NSMapTable* expressionRanges() {
+    static NSMapTable* ranges = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        ranges = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality
+                                       valueOptions:NSPointerFunctionsStrongMemory];
+    });
+    return ranges;
+}
+
 NSString *const MTParseErrorDomain = @"ParseError";
 NSString *const MTParseErrorOffset = @"ParseErrorOffset";
 
@@ -51,6 +65,25 @@ NSString *const MTParseErrorOffset = @"ParseErrorOffset";
     return self;
 }
 
++ (MTMathListRange *)rangeOfExpression:(MTExpression *)expr
+{
+    NSMapTable* ranges = expressionRanges();
+    @synchronized(ranges) {
+        return [ranges objectForKey:expr];
+    }
+}
+
++ (void)setRange:(MTMathListRange *)range forExpression:(MTExpression *)expr
+{
+    if (!range) {
+        return;
+    }
+    NSMapTable* ranges = expressionRanges();
+    @synchronized(ranges) {
+        [ranges setObject:range forKey:expr];
+    }
+}
+
 - (void) clear
 {
     _lhs = nil;
@@ -95,6 +128,18 @@ NSString *const MTParseErrorOffset = @"ParseErrorOffset";
 #pragma mark - String
 
 - (MTExpression*) parseFromString:(NSString*) string
+{
+    MTTraceRecorder* recorder = [MTTraceRecorder sharedRecorder];
+    if (!recorder) {
+        return [self parseExpressionFromString:string];
+    }
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    MTExpression* expr = [self parseExpressionFromString:string];
+    [recorder recordParseOfInput:string isMathList:NO entityType:kMTTypeAny result:expr duration:CFAbsoluteTimeGetCurrent() - start];
+    return expr;
+}
+
+- (MTExpression*) parseExpressionFromString:(NSString*) string
 {
     [self clear];
     MTTokenizer *tok = [[MTTokenizer alloc] initWithString:string];
@@ -165,6 +210,20 @@ NSString *const MTParseErrorOffset = @"ParseErrorOffset";
 #pragma mark - MathList
 
 - (id<MTMathEntity>) parseFromMathList:(MTMathList*) mathList expectedEntityType:(MTMathEntityType)entityType
+{
+    MTTraceRecorder* recorder = [MTTraceRecorder sharedRecorder];
+    if (!recorder) {
+        return [self parseEntityFromMathList:mathList expectedEntityType:entityType];
+    }
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    id<MTMathEntity> entity = [self parseEntityFromMathList:mathList expectedEntityType:entityType];
+    CFAbsoluteTime duration = CFAbsoluteTimeGetCurrent() - start;
+    // Converting to LaTeX is not included in the parse time.
+    [recorder recordParseOfInput:[MTMathListBuilder mathListToString:mathList] isMathList:YES entityType:entityType result:entity duration:duration];
+    return entity;
+}
+
+- (id<MTMathEntity>) parseEntityFromMathList:(MTMathList*) mathList expectedEntityType:(MTMathEntityType)entityType
 {
     [self clear];
 
@@ -491,7 +550,7 @@ NSString *const MTParseErrorOffset = @"ParseErrorOffset";
     }
 
     MTInfixParser *parser = [MTInfixParser new];
-    MTExpression* numerator = (MTExpression*) [parser parseFromMathList:frac.numerator expectedEntityType:kMTExpression];
+    MTExpression* numerator = (MTExpression*) [parser parseEntityFromMathList:frac.numerator expectedEntityType:kMTExpression];
     if (parser.hasError) {
         // Twiddle offsets to be in the numerator
         NSError* error = parser.error;
@@ -499,7 +558,7 @@ NSString *const MTParseErrorOffset = @"ParseErrorOffset";
         [self setError:parser.error.code text:error.localizedDescription index:fracIndex];
         return false;
     }
-    MTExpression* denominator = (MTExpression*)[parser parseFromMathList:frac.denominator expectedEntityType:kMTExpression];
+    MTExpression* denominator = (MTExpression*)[parser parseEntityFromMathList:frac.denominator expectedEntityType:kMTExpression];
     if (parser.hasError) {
         // Twiddle offsets to be in the denominator
         NSError* error = parser.error;
@@ -584,7 +643,8 @@ NSString *const MTParseErrorOffset = @"ParseErrorOffset";
             return NO;
         } else if (operator.offset.location <= arg2.range.start.atomIndex) {
             // the operator should come in between the 2 arguments, otherwise it is missing arguments.
-            MTOperator *op = [MTOperator operatorWithType:operator.charValue args:arg1:arg2];
+            MTMathListRange* range = (arg1.range && arg2.range) ? [arg1.range unionRange:arg2.range] : (arg1.range ?: arg2.range);
+            MTOperator *op = [MTOperator operatorWithType:operator.charValue args:arg1:arg2 range:range];
             [_expressionStack addObject:op];
             return YES;
         }
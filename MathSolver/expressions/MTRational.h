@@ -66,6 +66,13 @@ typedef enum
 + (MTRational*) zero;
 + (MTRational*) one;
 + (MTRational*) rationalWithNumber:(NSInteger) number;
+// The sum of count rationals with the given numerators and denominators, computed without creating the partial sums.
+// The result is the same as adding them one at a time with add:, so 1/2 + 1/4 is 6/8. The sum is not reduced.
+// Returns nil if it may not fit in an NSInteger.
++ (MTRational*) sumOfNumerators:(const NSInteger*) numerators denominators:(const NSInteger*) denominators count:(NSUInteger) count;
+// The product of count rationals, which is the same as multiplying them one at a time. Returns nil if it may not fit
+// in an NSInteger.
++ (MTRational*) productOfNumerators:(const NSInteger*) numerators denominators:(const NSInteger*) denominators count:(NSUInteger) count;
 // Parses a string of the form a.b where a and b are integers to a rational. Does not handle -ve signs.
 // If the string is not in the given format, this fails.
 + (MTRational*) rationalFromDecimalRepresentation:(NSString*) str;
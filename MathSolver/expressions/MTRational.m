@@ -19,9 +19,18 @@ static NSUInteger gcd(NSUInteger a, NSUInteger b) {
     return a;
 }
 
-// Represents a rational number
+// Whether a rational is reduced, computed the first time it is needed.
+typedef enum {
+    kMTReducedUnknown = 0,
+    kMTReducedYes,
+    kMTReducedNo,
+} MTReducedState;
+
+// Represents a rational number. Only whether it is reduced is cached rather than its gcd, which fits in the padding after
+// the format and keeps a rational in the 32 byte malloc size class.
 @implementation MTRational {
-    NSUInteger _gcd;
+    // An MTReducedState, stored in a byte.
+    uint8_t _reducedState;
 }
 
 + (instancetype) rationalWithNumerator:(NSInteger) numerator denominator:(NSInteger) denominator format:(MTRationalFormat) format;
@@ -45,18 +54,20 @@ static NSUInteger gcd(NSUInteger a, NSUInteger b) {
 + (MTRational *)zero
 {
     static MTRational* zero = nil;
-    if (!zero) {
+    static dispatch_once_t onceToken = 0;
+    dispatch_once(&onceToken, ^{
         zero = [MTRational rationalWithNumber:0];
-    }
+    });
     return zero;
 }
 
 + (MTRational *)one
 {
     static MTRational* one = nil;
-    if (!one) {
+    static dispatch_once_t onceToken = 0;
+    dispatch_once(&onceToken, ^{
         one = [MTRational rationalWithNumber:1];
-    }
+    });
     return one;
 }
 
@@ -65,6 +76,82 @@ static NSUInteger gcd(NSUInteger a, NSUInteger b) {
     return [[[self class] alloc] initWithNumerator:number denominator:1u format:kMTRationalFormatWhole];
 }
 
+static NSUInteger absoluteValue(NSInteger n) {
+    // Negate as unsigned so that NSIntegerMin does not overflow.
+    return (n < 0) ? 0 - (NSUInteger) n : (NSUInteger) n;
+}
+
+static NSUInteger bitLength(NSUInteger n) {
+    return (n == 0) ? 0 : sizeof(NSUInteger) * 8 - __builtin_clzl(n);
+}
+
++ (MTRational *)sumOfNumerators:(const NSInteger *)numerators denominators:(const NSInteger *)denominators count:(NSUInteger)count
+{
+    NSParameterAssert(count > 0);
+    // Like add:, a denominator which differs from the running one is multiplied into it.
+    NSInteger denominator = 1;
+    BOOL sameDenominator = YES;
+    for (NSUInteger i = 0; i < count; i++) {
+        sameDenominator &= (denominators[i] == denominators[0]);
+        if (denominators[i] != denominator && __builtin_mul_overflow(denominator, denominators[i], &denominator)) {
+            return nil;
+        }
+    }
+    // Every partial sum is at most count * max|numerator| * |denominator|, so bounding that up front keeps the
+    // summing loop free of overflow checks.
+    NSUInteger maxNumerator = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        maxNumerator = MAX(maxNumerator, absoluteValue(numerators[i]));
+    }
+    NSUInteger bound;
+    if (__builtin_mul_overflow(maxNumerator, absoluteValue(denominator), &bound) || __builtin_mul_overflow(bound, count, &bound)
+        || bound > NSIntegerMax) {
+        return nil;
+    }
+    NSInteger numerator = 0;
+    if (sameDenominator) {
+        // The common case, a plain sum which the compiler can vectorize.
+        for (NSUInteger i = 0; i < count; i++) {
+            numerator += numerators[i];
+        }
+        return [MTRational rationalWithNumerator:numerator denominator:denominator];
+    }
+    // Otherwise each step depends on the previous one, as it does for add:.
+    NSInteger runningDenominator = 1;
+    for (NSUInteger i = 0; i < count; i++) {
+        if (denominators[i] == runningDenominator) {
+            numerator += numerators[i];
+        } else {
+            numerator = numerator * denominators[i] + numerators[i] * runningDenominator;
+            runningDenominator *= denominators[i];
+        }
+    }
+    return [MTRational rationalWithNumerator:numerator denominator:denominator];
+}
+
++ (MTRational *)productOfNumerators:(const NSInteger *)numerators denominators:(const NSInteger *)denominators count:(NSUInteger)count
+{
+    NSParameterAssert(count > 0);
+    // A product has fewer bits than its factors put together, so bounding those up front keeps the loop free of
+    // overflow checks.
+    NSUInteger numeratorBits = 0;
+    NSUInteger denominatorBits = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        numeratorBits += bitLength(absoluteValue(numerators[i]));
+        denominatorBits += bitLength(absoluteValue(denominators[i]));
+    }
+    if (numeratorBits >= sizeof(NSInteger) * 8 || denominatorBits >= sizeof(NSInteger) * 8) {
+        return nil;
+    }
+    NSInteger numerator = 1;
+    NSInteger denominator = 1;
+    for (NSUInteger i = 0; i < count; i++) {
+        numerator *= numerators[i];
+        denominator *= denominators[i];
+    }
+    return [MTRational rationalWithNumerator:numerator denominator:denominator];
+}
+
 + (MTRational*)rationalFromDecimalRepresentation:(NSString *)str
 {
     NSParameterAssert(str);
@@ -124,7 +211,6 @@ static NSUInteger gcd(NSUInteger a, NSUInteger b) {
         _numerator = numerator;
         _denominator = denominator;
         _format = format;
-        _gcd = gcd(ABS(self.numerator), ABS(self.denominator));
     }
     return self;
 }
@@ -172,19 +258,25 @@ static NSUInteger gcd(NSUInteger a, NSUInteger b) {
 
 - (BOOL) isReduced
 {
-    return (_gcd == 1 && _denominator > 0);
+    // Rationals are immutable, so this is only computed once.
+    if (_reducedState == kMTReducedUnknown) {
+        _reducedState = (_denominator > 0 && gcd(ABS(_numerator), ABS(_denominator)) == 1) ? kMTReducedYes : kMTReducedNo;
+    }
+    return _reducedState == kMTReducedYes;
 }
 
 - (MTRational *)reduced
 {
     if (self.isReduced) {
         return self;
-    } else if (_gcd == 0) {
+    }
+    NSUInteger divisor = gcd(ABS(self.numerator), ABS(self.denominator));
+    if (divisor == 0) {
         return [MTRational zero];
     }
     // In C dividing an signed int by an unsigned will cause both to become unsigned!!, so cast to signed first.
-    NSInteger numerator = self.numerator/(NSInteger) _gcd;
-    NSInteger denominator = self.denominator / (NSInteger) _gcd;
+    NSInteger numerator = self.numerator/(NSInteger) divisor;
+    NSInteger denominator = self.denominator / (NSInteger) divisor;
     if (denominator < 0) {
         denominator = -denominator;
         numerator = -numerator;
@@ -233,17 +325,39 @@ static NSUInteger gcd(NSUInteger a, NSUInteger b) {
     return prime * self.denominator + self.numerator;
 }
 
+// Writes the value with as many fractional digits as its denominator needs, zero padded, e.g. 1/20 as 0.05. Returns nil if
+// the denominator does not divide a power of 10 that fits in an NSUInteger.
+- (NSString*) decimalDescription
+{
+    NSUInteger denominator = absoluteValue(_denominator);
+    if (denominator == 0) {
+        return nil;
+    }
+    NSUInteger scale = 1;
+    int digits = 0;
+    while (scale % denominator != 0) {
+        if (__builtin_mul_overflow(scale, 10, &scale)) {
+            return nil;
+        }
+        digits++;
+    }
+    NSUInteger numerator = absoluteValue(_numerator);
+    NSUInteger fractional;
+    if (__builtin_mul_overflow(numerator % denominator, scale / denominator, &fractional)) {
+        return nil;
+    }
+    BOOL negative = (_numerator < 0) != (_denominator < 0);
+    return [NSString stringWithFormat:@"%s%lu.%0*lu", negative ? "-" : "", (unsigned long)(numerator / denominator), digits, (unsigned long)fractional];
+}
+
 - (NSString *)description
 {
     if (_format == kMTRationalFormatWhole || _denominator == 1) {
         return [NSString stringWithFormat:@"%ld", (long)self.numerator];
-    } else if (_format == kMTRationalFormatDecimal) {
-        // write it in decimal format.
-        NSUInteger absNumerator = ABS(self.numerator);
-        NSUInteger integerVal = absNumerator/self.denominator;
-        NSUInteger decimalVal =  absNumerator - self.denominator*integerVal;
-        NSString* sign = (self.numerator < 0) ? @"-" : @"";
-        return [NSString stringWithFormat:@"%@%lu.%lu", sign, (unsigned long)integerVal, (unsigned long)decimalVal];
+    }
+    NSString* decimal = (_format == kMTRationalFormatDecimal) ? [self decimalDescription] : nil;
+    if (decimal) {
+        return decimal;
     } else {
         return [NSString stringWithFormat:@"%ld/%ld", (long)self.numerator, (long)self.denominator];
     }
@@ -251,7 +365,14 @@ static NSUInteger gcd(NSUInteger a, NSUInteger b) {
 
 - (BOOL)isEquivalent:(MTRational *)r
 {
-    if ([self.reduced isEqualToRational:r.reduced]) {
+    // a/b = c/d exactly when ad = cb, which avoids reducing both sides.
+    NSInteger lhs, rhs;
+    if (_denominator != 0 && r.denominator != 0
+        && !__builtin_mul_overflow(_numerator, r.denominator, &lhs) && !__builtin_mul_overflow(r.numerator, _denominator, &rhs)) {
+        if (lhs == rhs) {
+            return YES;
+        }
+    } else if ([self.reduced isEqualToRational:r.reduced]) {
         return YES;
     } else if (lroundf(self.floatValue * 100) ==  lroundf(r.floatValue*100)) {
         // Decimal expansions are close, then these are equivalent
@@ -0,0 +1,152 @@
+//
+//  EquationSystemTest.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "MTEquationSystem.h"
+#import "MTInfixParser.h"
+#import "MTMathListBuilder.h"
+
+@interface EquationSystemTest : XCTestCase
+
+@end
+
+@implementation EquationSystemTest
+
+- (MTEquationSystem*) systemFromStrings:(NSArray*) strings
+{
+    NSMutableArray* equations = [NSMutableArray arrayWithCapacity:strings.count];
+    for (NSString* str in strings) {
+        MTInfixParser *parser = [MTInfixParser new];
+        [equations addObject:[parser parseToEquationFromMathList:[MTMathListBuilder buildFromString:str]]];
+    }
+    return [MTEquationSystem systemWithEquations:equations];
+}
+
+// equations, solution
+static NSArray* getTestData() {
+    return @[
+             @[ @[ @"x + y = 3", @"x - y = 1" ], @[ @"x = 2", @"y = 1" ] ],
+             @[ @[ @"2x = 5" ], @[ @"x = 5/2" ] ],
+             @[ @[ @"2x + 3y = 1", @"x = y + 3" ], @[ @"x = 2", @"y = -1" ] ],
+             @[ @[ @"\\frac{x}{2} + \\frac{y}{3} = 1", @"x + y + z = 0", @"z - x = 1" ], @[ @"x = -8", @"y = 15", @"z = -7" ] ],
+             // A redundant equation is fine
+             @[ @[ @"x + y = 3", @"x - y = 1", @"2x + 2y = 6" ], @[ @"x = 2", @"y = 1" ] ],
+             ];
+}
+
+- (void) testSolve
+{
+    for (NSArray* testCase in getTestData()) {
+        MTEquationSystem* system = [self systemFromStrings:testCase[0]];
+        NSArray* solution = [system solve];
+        NSArray* expected = testCase[1];
+        XCTAssertEqual(solution.count, expected.count, @"For %@", system);
+        for (NSUInteger i = 0; i < expected.count && i < solution.count; i++) {
+            XCTAssertEqualObjects([solution[i] stringValue], expected[i], @"For %@", system);
+        }
+    }
+}
+
+- (void) testNoUniqueSolution
+{
+    // infinitely many solutions
+    XCTAssertNil([[self systemFromStrings:@[ @"x + y = 3", @"2x + 2y = 6" ]] solve]);
+    // inconsistent
+    XCTAssertNil([[self systemFromStrings:@[ @"x + y = 3", @"x + y = 4" ]] solve]);
+    XCTAssertNil([[self systemFromStrings:@[ @"x + y = 3", @"x - y = 1", @"x = 5" ]] solve]);
+    // not linear
+    XCTAssertNil([[self systemFromStrings:@[ @"xy = 3", @"x - y = 1" ]] solve]);
+    XCTAssertNil([[self systemFromStrings:@[ @"\\frac1x = 3", @"x - y = 1" ]] solve]);
+}
+
+- (void) testVariables
+{
+    MTEquationSystem* system = [self systemFromStrings:@[ @"z + x = 3", @"y = 1" ]];
+    XCTAssertEqualObjects([system.variables valueForKey:@"stringValue"], (@[ @"x", @"y", @"z" ]));
+}
+
+// A tridiagonal system with 2 on the diagonal and -1 next to it, whose solution is x_i = 1.
+static NSArray* getTridiagonalMatrix(NSUInteger n) {
+    NSMutableArray* matrix = [NSMutableArray arrayWithCapacity:n];
+    for (NSUInteger i = 0; i < n; i++) {
+        NSMutableArray* row = [NSMutableArray arrayWithCapacity:n + 1];
+        for (NSUInteger j = 0; j < n; j++) {
+            NSInteger value = (i == j) ? 2 : ((i == j + 1 || j == i + 1) ? -1 : 0);
+            [row addObject:[MTRational rationalWithNumber:value]];
+        }
+        // the row sum
+        [row addObject:[MTRational rationalWithNumber:(i == 0 || i == n - 1) ? 1 : 0]];
+        [matrix addObject:row];
+    }
+    return matrix;
+}
+
+- (void) testLargeSystem
+{
+    NSArray* values = [MTEquationSystem solveAugmentedMatrix:getTridiagonalMatrix(40)];
+    XCTAssertEqual(values.count, 40u);
+    for (MTRational* value in values) {
+        XCTAssertEqualObjects(value, [MTRational one]);
+    }
+}
+
+// A dense system with entries between -9 and 9 whose solution is x_j = (j - n/2) / 6. The minors have hundreds of bits.
+static NSArray* getDenseMatrix(NSUInteger n) {
+    NSMutableArray* matrix = [NSMutableArray arrayWithCapacity:n];
+    uint32_t seed = 1;
+    for (NSUInteger i = 0; i < n; i++) {
+        NSMutableArray* row = [NSMutableArray arrayWithCapacity:n + 1];
+        NSInteger sum = 0;
+        for (NSUInteger j = 0; j < n; j++) {
+            seed = seed * 1103515245 + 12345;
+            NSInteger value = (NSInteger) ((seed >> 16) % 19) - 9;
+            [row addObject:[MTRational rationalWithNumber:value]];
+            sum += value * ((NSInteger) j - (NSInteger) n / 2);
+        }
+        [row addObject:[MTRational rationalWithNumerator:sum denominator:6]];
+        [matrix addObject:row];
+    }
+    return matrix;
+}
+
+- (void) testDenseSystem
+{
+    for (NSUInteger n = 5; n <= 40; n += 5) {
+        NSArray* values = [MTEquationSystem solveAugmentedMatrix:getDenseMatrix(n)];
+        XCTAssertEqual(values.count, n, @"For %lu variables", (unsigned long) n);
+        for (NSUInteger j = 0; j < values.count; j++) {
+            MTRational* expected = [[MTRational rationalWithNumerator:(NSInteger) j - (NSInteger) n / 2 denominator:6] reduced];
+            XCTAssertEqualObjects(values[j], expected, @"For x_%lu with %lu variables", (unsigned long) j, (unsigned long) n);
+        }
+    }
+}
+
+- (void) testPerformanceSolveDense
+{
+    NSArray* matrix = getDenseMatrix(40);
+    [self measureBlock:^{
+        for (int i = 0; i < 10; i++) {
+            [MTEquationSystem solveAugmentedMatrix:matrix];
+        }
+    }];
+}
+
+- (void) testPerformanceSolve
+{
+    NSArray* matrix = getTridiagonalMatrix(40);
+    [self measureBlock:^{
+        for (int i = 0; i < 100; i++) {
+            [MTEquationSystem solveAugmentedMatrix:matrix];
+        }
+    }];
+}
+
+@end
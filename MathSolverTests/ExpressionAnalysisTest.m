@@ -0,0 +1,80 @@
+//
+//  ExpressionAnalysisTest.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "MTExpressionAnalysis.h"
+#import "MTCancellationToken.h"
+#import "MTCanonicalizer.h"
+#import "MTInfixParser.h"
+#import "MTMathListBuilder.h"
+
+@interface ExpressionAnalysisTest : XCTestCase
+
+@end
+
+@implementation ExpressionAnalysisTest
+
+- (MTEquation*) parseEquation:(NSString*) str
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    return [parser parseToEquationFromMathList:[MTMathListBuilder buildFromString:str]];
+}
+
+- (MTExpression*) parseExpression:(NSString*) str
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    return [parser parseToExpressionFromMathList:[MTMathListBuilder buildFromString:str]];
+}
+
+- (void) testAnalyzeExpression
+{
+    MTEquation* eq = [self parseEquation:@"2x + 3 = 5"];
+    XCTestExpectation* expectation = [self expectationWithDescription:@"analysis"];
+    [MTExpressionAnalysis analyzeExpression:eq input:nil cancellationToken:[MTCancellationToken token] queue:dispatch_get_main_queue()
+                                 completion:^(MTExpressionInfo *info, BOOL hasCheckableAnswer) {
+        XCTAssertTrue([NSThread isMainThread]);
+        XCTAssertEqualObjects(info.original, eq);
+        XCTAssertNotNil(info.normalForm);
+        XCTAssertTrue(hasCheckableAnswer);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+}
+
+- (void) testCancelledCanonicalization
+{
+    MTCancellationToken* token = [MTCancellationToken token];
+    XCTAssertFalse(token.isCancelled);
+    [token cancel];
+    XCTAssertTrue(token.isCancelled);
+
+    MTExpressionCanonicalizer* canonicalizer = [MTCanonicalizerFactory getExpressionCanonicalizer];
+    MTExpression* expr = [canonicalizer normalize:[self parseExpression:@"x + 1/x + 2/y"]];
+    XCTAssertNil([canonicalizer normalForm:expr cancellationToken:token]);
+    XCTAssertEqualObjects([canonicalizer normalForm:expr cancellationToken:[MTCancellationToken token]], [canonicalizer normalForm:expr]);
+
+    MTEquationCanonicalizer* eqCanonicalizer = [MTCanonicalizerFactory getEquationCanonicalizer];
+    MTEquation* eq = [eqCanonicalizer normalize:[self parseEquation:@"1/x = 2"]];
+    XCTAssertNil([eqCanonicalizer normalForm:eq cancellationToken:token]);
+}
+
+- (void) testCancelledExpressionInfo
+{
+    MTCancellationToken* token = [MTCancellationToken token];
+    [token cancel];
+    MTExpressionInfo* info = [[MTExpressionInfo alloc] initWithExpression:[self parseExpression:@"x + 1/x"] input:nil];
+    XCTAssertFalse([info computeNormalFormWithCancellationToken:token]);
+    // computed again on access
+    XCTAssertNotNil(info.normalForm);
+    XCTAssertTrue([info computeNormalFormWithCancellationToken:token]);
+}
+
+@end
@@ -0,0 +1,146 @@
+//
+//  ExpressionInfoTest.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <XCTest/XCTest.h>
+#import <malloc/malloc.h>
+#import <objc/runtime.h>
+
+#import "MTExpressionInfo.h"
+#import "MTCanonicalizer.h"
+#import "MTInfixParser.h"
+#import "MTMathListBuilder.h"
+#import "MTFlattenRule.h"
+
+@interface ExpressionInfoTest : XCTestCase
+
+@end
+
+@implementation ExpressionInfoTest
+
+- (MTExpression*) parseExpression:(NSString*) expr
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    return [parser parseToExpressionFromMathList:[MTMathListBuilder buildFromString:expr]];
+}
+
+static NSArray* getTestExpressions() {
+    return @[ @"x", @"2(x + 3) - 4(x - \\frac12)", @"3 / (5x) + 6", @"x + 1/x + 2/y" ];
+}
+
+- (void) testLazyComputation
+{
+    MTExpressionCanonicalizer* canonicalizer = [MTCanonicalizerFactory getExpressionCanonicalizer];
+    for (NSString* testExpr in getTestExpressions()) {
+        MTExpression* expr = [self parseExpression:testExpr];
+        MTExpressionInfo* info = [[MTExpressionInfo alloc] initWithExpression:expr input:nil];
+        MTExpression* normalized = [canonicalizer normalize:expr];
+        XCTAssertEqualObjects(info.original, expr, @"For %@", testExpr);
+        XCTAssertEqualObjects(info.normalized, normalized, @"For %@", testExpr);
+        XCTAssertEqualObjects(info.normalForm, [canonicalizer normalForm:normalized], @"For %@", testExpr);
+        // computed only once
+        XCTAssertEqual(info.normalForm, info.normalForm, @"For %@", testExpr);
+    }
+}
+
+- (void) testVariableOnly
+{
+    MTExpressionInfo* info = [[MTExpressionInfo alloc] initWithVariable:@"x"];
+    XCTAssertNil(info.original);
+    XCTAssertNil(info.normalized);
+    XCTAssertNil(info.normalForm);
+    XCTAssertEqualObjects(info.variableName, @"x");
+}
+
+- (void) testComputeNormalForms
+{
+    MTExpressionCanonicalizer* canonicalizer = [MTCanonicalizerFactory getExpressionCanonicalizer];
+    NSMutableArray* infos = [NSMutableArray array];
+    for (NSString* testExpr in getTestExpressions()) {
+        [infos addObject:[[MTExpressionInfo alloc] initWithExpression:[self parseExpression:testExpr] input:nil]];
+    }
+    [MTExpressionInfo computeNormalForms:infos];
+    for (MTExpressionInfo* info in infos) {
+        XCTAssertEqualObjects(info.normalForm, [canonicalizer normalForm:[canonicalizer normalize:info.original]]);
+    }
+}
+
+- (void) testConcurrentAccess
+{
+    MTExpressionInfo* info = [[MTExpressionInfo alloc] initWithExpression:[self parseExpression:@"x + 1/x + 2/y"] input:nil];
+    NSMutableSet* results = [NSMutableSet set];
+    NSMutableSet* normalizedResults = [NSMutableSet set];
+    dispatch_apply(16, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        // Half the threads only read the normalized expression, which has its own lock.
+        id<MTMathEntity> normalized = info.normalized;
+        id<MTMathEntity> normalForm = (i % 2) ? info.normalForm : nil;
+        @synchronized(results) {
+            [normalizedResults addObject:[NSValue valueWithNonretainedObject:normalized]];
+            if (normalForm) {
+                [results addObject:[NSValue valueWithNonretainedObject:normalForm]];
+            }
+        }
+    });
+    // Every thread sees the same object.
+    XCTAssertEqual(results.count, 1u);
+    XCTAssertEqual(normalizedResults.count, 1u);
+}
+
+- (void) testRetainedBytes
+{
+    MTExpressionInfo* info = [[MTExpressionInfo alloc] initWithExpression:[self parseExpression:@"x + 1/x + 2/y"] input:nil];
+    NSUInteger originalBytes = info.retainedBytes;
+    XCTAssertGreaterThan(originalBytes, 0u);
+    [info normalForm];
+    XCTAssertGreaterThan(info.retainedBytes, originalBytes);
+    XCTAssertEqual([[MTExpressionInfo alloc] initWithVariable:@"x"].retainedBytes, 0u);
+}
+
+- (void) testRangeOnlyForParsedExpressions
+{
+    MTExpression* parsed = [self parseExpression:@"x + 1"];
+    XCTAssertNotNil(parsed.range);
+    XCTAssertNotNil([parsed.children[0] range]);
+    MTExpression* created = [MTOperator operatorWithType:kMTAddition args:[MTVariable variableWithName:'x'] :[MTNumber numberWithValue:[MTRational one]]];
+    XCTAssertNil(created.range);
+    XCTAssertNil([created.children[0] range]);
+    // Equality does not depend on the range.
+    XCTAssertEqualObjects(created, parsed);
+    XCTAssertNotNil([created expressionWithRange:parsed.range].range);
+}
+
+- (void) testRuleOutputHasNoRange
+{
+    MTExpression* parsed = [self parseExpression:@"(x + 1) + 2"];
+    MTExpression* flattened = [[MTFlattenRule rule] apply:parsed];
+    XCTAssertNotNil(parsed.range);
+    XCTAssertNil(flattened.range);
+    // The children which were not changed are shared with the parsed expression and keep their ranges.
+    XCTAssertNotNil([flattened.children[0] range]);
+}
+
+- (void) testRetainedBytesPerNode
+{
+    // Nodes do not have an ivar for the range, so a number or a variable is just the isa and its value.
+    XCTAssertLessThanOrEqual(class_getInstanceSize([MTNumber class]), 2 * sizeof(void*));
+    XCTAssertLessThanOrEqual(class_getInstanceSize([MTVariable class]), 2 * sizeof(void*));
+
+    // The same tree built by the rules retains only the nodes, the parsed one retains the ranges as well.
+    MTExpression* parsed = [self parseExpression:@"x + 1"];
+    MTExpression* created = [MTOperator operatorWithType:kMTAddition args:[MTVariable variableWithName:'x'] :[MTNumber numberWithValue:[MTRational one]]];
+    NSUInteger parsedBytes = [[MTExpressionInfo alloc] initWithExpression:parsed input:nil].retainedBytes;
+    NSUInteger createdBytes = [[MTExpressionInfo alloc] initWithExpression:created input:nil].retainedBytes;
+    NSUInteger rangeBytes = 0;
+    for (MTExpression* expr in @[parsed, parsed.children[0], parsed.children[1]]) {
+        rangeBytes += malloc_size((__bridge const void*) expr.range);
+    }
+    XCTAssertEqual(parsedBytes, createdBytes + rangeBytes);
+}
+
+@end
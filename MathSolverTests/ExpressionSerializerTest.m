@@ -0,0 +1,128 @@
+//
+//  ExpressionSerializerTest.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "MTExpressionSerializer.h"
+#import "MTInfixParser.h"
+#import "MTCanonicalizer.h"
+#import "MTMathListBuilder.h"
+
+@interface ExpressionSerializerTest : XCTestCase
+
+@end
+
+@implementation ExpressionSerializerTest
+
+- (MTExpression*) parseExpression:(NSString*) expr
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    return [parser parseFromString:expr];
+}
+
+- (MTExpression*) parseMathList:(MTMathList*) mathList
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    return [parser parseToExpressionFromMathList:mathList];
+}
+
+// expression, string, latex
+static NSArray* getTestData() {
+    return @[
+             @[ @"x", @"x", @"x" ],
+             @[ @"3", @"3", @"3" ],
+             @[ @"x+3", @"(x + 3)", @"x + 3" ],
+             @[ @"2*x+3", @"((2 * x) + 3)", @"2x + 3" ],
+             @[ @"2*(x+3)", @"(2 * (x + 3))", @"2(x + 3)" ],
+             @[ @"2*3", @"(2 * 3)", @"2 \\times 3" ],
+             @[ @"x-(y-3)", @"(x - (y - 3))", @"x - (y - 3)" ],
+             @[ @"(x-y)-3", @"((x - y) - 3)", @"x - y - 3" ],
+             @[ @"-x", @"(_ x)", @"-x" ],
+             @[ @"-(x+1)", @"(_ (x + 1))", @"-(x + 1)" ],
+             @[ @"x+(-y)", @"(x + (_ y))", @"x + (-y)" ],
+             @[ @"(x+1)/(y-2)", @"((x + 1) / (y - 2))", @"\\frac{x + 1}{y - 2}" ],
+             @[ @"x/2 + 3/4", @"((x / 2) + (3 / 4))", @"\\frac{x}{2} + \\frac{3}{4}" ],
+             @[ @"0.05 + x", @"(0.05 + x)", @"0.05 + x" ],
+             @[ @"1.005*x", @"(1.005 * x)", @"1.005x" ],
+             ];
+}
+
+- (void) testStringValue
+{
+    for (NSArray* testCase in getTestData()) {
+        MTExpression* expr = [self parseExpression:testCase[0]];
+        XCTAssertEqualObjects([MTExpressionSerializer stringForEntity:expr], testCase[1], @"For %@", testCase[0]);
+        XCTAssertEqualObjects(expr.stringValue, testCase[1], @"For %@", testCase[0]);
+    }
+}
+
+- (void) testLatex
+{
+    for (NSArray* testCase in getTestData()) {
+        MTExpression* expr = [self parseExpression:testCase[0]];
+        XCTAssertEqualObjects([MTExpressionSerializer latexForEntity:expr], testCase[2], @"For %@", testCase[0]);
+    }
+}
+
+- (void) testNumbers
+{
+    MTNumber* whole = [MTNumber numberWithValue:[MTRational rationalWithNumber:-5]];
+    XCTAssertEqualObjects([MTExpressionSerializer stringForEntity:whole], @"-5");
+    XCTAssertEqualObjects([MTExpressionSerializer latexForEntity:whole], @"-5");
+    MTNumber* fraction = [MTNumber numberWithValue:[MTRational rationalWithNumerator:3 denominator:4]];
+    XCTAssertEqualObjects([MTExpressionSerializer stringForEntity:fraction], @"3/4");
+    XCTAssertEqualObjects([MTExpressionSerializer latexForEntity:fraction], @"\\frac{3}{4}");
+    // A number prints the same alone as inside an operator.
+    MTNumber* decimal = [MTNumber numberWithValue:[MTRational rationalFromDecimalRepresentation:@"0.05"]];
+    XCTAssertEqualObjects(decimal.stringValue, @"0.05");
+    XCTAssertEqualObjects([MTExpressionSerializer stringForEntity:decimal], @"0.05");
+    XCTAssertEqualObjects([MTExpressionSerializer latexForEntity:decimal], @"0.05");
+    MTExpression* product = [MTOperator operatorWithType:kMTMultiplication args:[self parseExpression:@"x"] :whole];
+    XCTAssertEqualObjects([MTExpressionSerializer stringForEntity:product], @"(x * -5)");
+    XCTAssertEqualObjects([MTExpressionSerializer latexForEntity:product], @"x \\times (-5)");
+}
+
+- (void) testEquation
+{
+    MTEquation* eq = [MTEquation equationWithRelation:'=' lhs:[self parseExpression:@"2*x+3"] rhs:[self parseExpression:@"5"]];
+    XCTAssertEqualObjects([MTExpressionSerializer stringForEntity:eq], @"((2 * x) + 3) = 5");
+    XCTAssertEqualObjects(eq.stringValue, @"((2 * x) + 3) = 5");
+    XCTAssertEqualObjects([MTExpressionSerializer latexForEntity:eq], @"2x + 3 = 5");
+}
+
+- (void) testRoundTrip
+{
+    MTExpressionCanonicalizer* canonicalizer = [MTCanonicalizerFactory getExpressionCanonicalizer];
+    for (NSArray* testCase in getTestData()) {
+        MTExpression* expr = [self parseExpression:testCase[0]];
+        MTExpression* normalized = [canonicalizer normalize:expr];
+        NSString* latex = [MTExpressionSerializer latexForEntity:expr];
+        MTExpression* fromLatex = [self parseMathList:[MTMathListBuilder buildFromString:latex]];
+        XCTAssertEqualObjects([canonicalizer normalize:fromLatex], normalized, @"For %@", testCase[0]);
+        MTExpression* fromMathList = [self parseMathList:[MTExpressionSerializer mathListForEntity:expr]];
+        XCTAssertEqualObjects([canonicalizer normalize:fromMathList], normalized, @"For %@", testCase[0]);
+    }
+}
+
+- (void) testPerformanceStringValue
+{
+    MTExpression* expr = [self parseExpression:@"1"];
+    for (int i = 2; i < 200; i++) {
+        MTExpression* term = [MTOperator operatorWithType:kMTMultiplication args:[MTNumber numberWithValue:[MTRational rationalWithNumber:i]] :[self parseExpression:@"x+1"]];
+        expr = [MTOperator operatorWithType:(i % 2) ? kMTAddition : kMTSubtraction args:expr :term];
+    }
+    [self measureBlock:^{
+        for (int i = 0; i < 100; i++) {
+            [MTExpressionSerializer stringForEntity:expr];
+        }
+    }];
+}
+
+@end
@@ -65,6 +65,31 @@ static NSDictionary* getTestData() {
     }
 }
 
+- (void) testOpcode
+{
+    MTExpression* x = [MTVariable variableWithName:'x'];
+    MTExpression* two = [MTNumber numberWithValue:[MTRational rationalWithNumber:2]];
+    XCTAssertEqual(x.opcode, kMTOpcodeVariable);
+    XCTAssertEqual(two.opcode, kMTOpcodeNumber);
+    XCTAssertEqual([MTNull null].opcode, kMTOpcodeNull);
+    XCTAssertEqual([MTOperator operatorWithType:kMTAddition args:x :two].opcode, kMTOpcodeAddition);
+    XCTAssertEqual([MTOperator operatorWithType:kMTSubtraction args:x :two].opcode, kMTOpcodeSubtraction);
+    XCTAssertEqual([MTOperator operatorWithType:kMTMultiplication args:@[x, two, x]].opcode, kMTOpcodeMultiplication);
+    XCTAssertEqual([MTOperator operatorWithType:kMTDivision args:x :two range:nil].opcode, kMTOpcodeDivision);
+    XCTAssertEqual([MTOperator unaryOperatorWithType:kMTUnaryMinus arg:x range:nil].opcode, kMTOpcodeUnaryMinus);
+    XCTAssertEqual([MTOperator operatorWithType:'^' args:x :two].opcode, kMTOpcodeUnknownOperator);
+
+    // equalsExpressionValue: agrees with the boxed expressionValue.
+    XCTAssertTrue([x equalsExpressionValue:'x']);
+    XCTAssertFalse([x equalsExpressionValue:'y']);
+    XCTAssertTrue([two equalsExpressionValue:2]);
+    XCTAssertTrue([[MTNumber numberWithValue:[MTRational rationalWithNumerator:4 denominator:2]] equalsExpressionValue:2]);
+    XCTAssertFalse([two equalsExpressionValue:'+']);
+    XCTAssertTrue([[MTOperator operatorWithType:kMTAddition args:x :two] equalsExpressionValue:kMTAddition]);
+    XCTAssertFalse([[MTOperator operatorWithType:kMTAddition args:x :two] equalsExpressionValue:kMTMultiplication]);
+    XCTAssertFalse([[MTNull null] equalsExpressionValue:0]);
+}
+
 static NSArray* getTestDataForRearrangement() {
     return @[
              @[@"x + y", @"y + x", @YES],
@@ -107,4 +107,14 @@ static NSArray* getTestDataForDiff() {
     }
 }
 
+- (void) testSizeOfExpression
+{
+    XCTAssertEqual([MTExpressionUtil sizeOfExpression:[self parseExpression:@"x"]], 1u);
+    XCTAssertEqual([MTExpressionUtil sizeOfExpression:[self parseExpression:@"2*x + 3"]], 5u);
+    MTOperator* expr = (MTOperator*) [self parseExpression:@"(x+1)/(2*y - 3)"];
+    XCTAssertEqual(expr.size, 9u);
+    // The cached size is the same on the second call.
+    XCTAssertEqual([MTExpressionUtil sizeOfExpression:expr], 9u);
+}
+
 @end
@@ -110,6 +110,56 @@
     }
 }
 
+- (void) testSumOfNumerators
+{
+    {
+        // common denominators are kept
+        NSInteger numerators[] = { 1, 2, -4 };
+        NSInteger denominators[] = { 3, 3, 3 };
+        MTRational* sum = [MTRational sumOfNumerators:numerators denominators:denominators count:3];
+        XCTAssertEqual(sum.numerator, -1);
+        XCTAssertEqual(sum.denominator, 3);
+    }
+
+    {
+        // different denominators are added the same way as add:
+        NSInteger numerators[] = { 1, 1, 5, 3 };
+        NSInteger denominators[] = { 2, 4, 6, 6 };
+        MTRational* sum = [MTRational sumOfNumerators:numerators denominators:denominators count:4];
+        MTRational* added = [[[MTRational rationalWithNumerator:1 denominator:2] add:[MTRational rationalWithNumerator:1 denominator:4]]
+                             add:[MTRational rationalWithNumerator:5 denominator:6]];
+        added = [added add:[MTRational rationalWithNumerator:3 denominator:6]];
+        XCTAssertEqualObjects(sum, added);
+        XCTAssertEqual(sum.numerator, 600);
+        XCTAssertEqual(sum.denominator, 288);
+    }
+
+    {
+        // overflow
+        NSInteger numerators[] = { NSIntegerMax, 1 };
+        NSInteger denominators[] = { 1, 1 };
+        XCTAssertNil([MTRational sumOfNumerators:numerators denominators:denominators count:2]);
+    }
+}
+
+- (void) testProductOfNumerators
+{
+    {
+        NSInteger numerators[] = { 1, -2, 3 };
+        NSInteger denominators[] = { 2, 3, 3 };
+        MTRational* product = [MTRational productOfNumerators:numerators denominators:denominators count:3];
+        XCTAssertEqual(product.numerator, -6);
+        XCTAssertEqual(product.denominator, 18);
+    }
+
+    {
+        // overflow
+        NSInteger numerators[] = { NSIntegerMax, 2 };
+        NSInteger denominators[] = { 1, 1 };
+        XCTAssertNil([MTRational productOfNumerators:numerators denominators:denominators count:2]);
+    }
+}
+
 - (void) testSubtract
 {
     {
@@ -320,6 +370,13 @@
         XCTAssertFalse([p isEquivalent:q], @"");
         XCTAssertFalse([q isEquivalent:p], @"");
     }
+    {
+        // The cross products overflow, so these are compared reduced.
+        MTRational *p = [MTRational rationalWithNumerator:NSIntegerMax / 5 * 2 denominator:NSIntegerMax / 5 * 4];
+        MTRational *q = [MTRational rationalWithNumerator:NSIntegerMax / 7 denominator:NSIntegerMax / 7 * 2];
+        XCTAssertTrue([p isEquivalent:q], @"");
+        XCTAssertTrue([q isEquivalent:p], @"");
+    }
 }
 
 - (void) testCompare
@@ -439,5 +496,11 @@
         MTRational* testCase = [MTRational rationalWithNumerator:6 denominator:3];
         XCTAssertEqualObjects(testCase.description, @"6/3", @"");
     }
+    {
+        // leading zeros of the fractional part
+        MTRational* testCase = [MTRational rationalFromDecimalRepresentation:@"0.05"];
+        XCTAssertEqualObjects(testCase.description, @"0.05", @"");
+        XCTAssertEqualObjects([MTRational rationalFromDecimalRepresentation:@"1.005"].description, @"1.005", @"");
+    }
 }
 @end
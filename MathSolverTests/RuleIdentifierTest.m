@@ -0,0 +1,95 @@
+//
+//  RuleIdentifierTest.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "MTRuleIdentifier.h"
+#import "MTInfixParser.h"
+#import "MTFlattenRule.h"
+#import "MTCalculateRule.h"
+#import "MTIdentityRule.h"
+#import "MTDistributionRule.h"
+#import "MTCollectLikeTermsRule.h"
+#import "MTReorderTermsRule.h"
+
+@interface RuleIdentifierTest : XCTestCase
+
+@end
+
+@implementation RuleIdentifierTest
+
+- (MTExpression*) parseExpression:(NSString*) expr
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    return [parser parseFromString:expr];
+}
+
+// previous, next, rule class, location
+static NSArray* getTestData() {
+    return @[
+             @[ @"2*(x+3)", @"2*x + 2*3", [MTDistributionRule class], @[] ],
+             @[ @"y + 2*(x+3)", @"y + (2*x + 2*3)", [MTDistributionRule class], @[@1] ],
+             @[ @"x*1 + 3", @"x + 3", [MTIdentityRule class], @[@0] ],
+             @[ @"y * (x + 2*3)", @"y * (x + 6)", [MTCalculateRule class], @[@1, @1] ],
+             @[ @"y * (2*3 + x + 2*4)", @"y * (6 + x + 8)", [MTCalculateRule class], @[@1] ],
+             @[ @"3*x + 2*x", @"5*x", [MTCollectLikeTermsRule class], @[] ],
+             @[ @"x + 3", @"3 + x", [MTReorderTermsRule class], @[] ],
+             @[ @"y * (x + 3)", @"y * (3 + x)", [MTReorderTermsRule class], @[@1] ],
+             @[ @"x*y + z*w", @"w*z + y*x", [MTReorderTermsRule class], @[] ],
+             @[ @"2*3 + x + 2*3", @"2*3 + x + 6", [MTCalculateRule class], @[@2] ],
+             ];
+}
+
+- (void) testIdentifyRule
+{
+    MTRuleIdentifier* identifier = [MTRuleIdentifier new];
+    MTFlattenRule* flatten = [MTFlattenRule rule];
+    for (NSArray* testCase in getTestData()) {
+        NSString* desc = [NSString stringWithFormat:@"Error for %@ => %@", testCase[0], testCase[1]];
+        MTExpression* previous = [self parseExpression:testCase[0]];
+        MTExpression* next = [self parseExpression:testCase[1]];
+        if ([testCase[2] isEqual:[MTCalculateRule class]]) {
+            // the parser does not flatten, so flatten the sums to get the same shape as the rule output
+            previous = [flatten apply:previous];
+            next = [flatten apply:next];
+        }
+        MTRuleIdentification* identification = [identifier identifyRuleFrom:previous to:next];
+        XCTAssertNotNil(identification, @"%@", desc);
+        XCTAssertEqualObjects([identification.rule class], testCase[2], @"%@", desc);
+        NSArray* location = testCase[3];
+        XCTAssertEqual(identification.location.length, location.count, @"%@", desc);
+        for (NSUInteger i = 0; i < location.count; i++) {
+            XCTAssertEqual([identification.location indexAtPosition:i], [location[i] unsignedIntegerValue], @"%@", desc);
+        }
+    }
+}
+
+- (void) testNoRule
+{
+    MTRuleIdentifier* identifier = [MTRuleIdentifier new];
+    XCTAssertNil([identifier identifyRuleFrom:[self parseExpression:@"x + 3"] to:[self parseExpression:@"x + 3"]]);
+    XCTAssertNil([identifier identifyRuleFrom:[self parseExpression:@"x + 3"] to:[self parseExpression:@"x + 4"]]);
+}
+
+- (void) testDerivation
+{
+    MTRuleIdentifier* identifier = [MTRuleIdentifier new];
+    NSArray* steps = @[[self parseExpression:@"2*(x+3)"],
+                       [self parseExpression:@"2*x + 2*3"],
+                       [self parseExpression:@"2*x + 6"],
+                       [self parseExpression:@"2*x + 7"]];
+    NSArray* results = [identifier identifyRulesInDerivation:steps];
+    XCTAssertEqual(results.count, 3u);
+    XCTAssertEqualObjects([[results[0] rule] class], [MTDistributionRule class]);
+    XCTAssertEqualObjects([[results[1] rule] class], [MTCalculateRule class]);
+    XCTAssertEqualObjects(results[2], [NSNull null]);
+}
+
+@end
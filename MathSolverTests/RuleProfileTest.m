@@ -0,0 +1,138 @@
+//
+//  RuleProfileTest.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "MTRuleProfile.h"
+#import "MTInfixParser.h"
+#import "MTCalculateRule.h"
+#import "MTIdentityRule.h"
+#import "MTFlattenRule.h"
+#import "MTNullRule.h"
+#import "MTZeroRule.h"
+
+@interface RuleProfileTest : XCTestCase
+
+@end
+
+@implementation RuleProfileTest
+
+- (MTExpression*) parseExpression:(NSString*) expr
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    // flatten to get the terms the canonicalizer sees
+    return [[MTFlattenRule rule] apply:[parser parseFromString:expr]];
+}
+
+// expression, class
+static NSArray* getTestData() {
+    return @[
+             @[ @"5", @"d0 t1" ],
+             @[ @"x", @"d1 t1" ],
+             @[ @"x+3", @"d1 t2" ],
+             @[ @"x*x + 2*x + 1", @"d2 t3" ],
+             @[ @"x*x*x*x", @"d3 t1" ],
+             @[ @"x + 1/x", @"r t2" ],
+             @[ @"(x+1)/2", @"r t1" ],
+             ];
+}
+
+- (void) testClassOfExpression
+{
+    for (NSArray* testCase in getTestData()) {
+        MTExpression* expr = [self parseExpression:testCase[0]];
+        XCTAssertEqualObjects([MTRuleProfile classOfExpression:expr], testCase[1], @"For %@", testCase[0]);
+    }
+}
+
+- (void) testOrderRules
+{
+    MTRule* calculate = [MTCalculateRule rule];
+    MTRule* identity = [MTIdentityRule rule];
+    MTRule* flatten = [MTFlattenRule rule];
+    NSArray* rules = @[calculate, identity, flatten];
+
+    MTRuleProfile* profile = [MTRuleProfile new];
+    XCTAssertEqualObjects([profile orderRules:rules forKey:@"d1 t2"], rules);
+    [profile recordRule:flatten firedForKey:@"d1 t2"];
+    [profile recordRule:flatten firedForKey:@"d1 t2"];
+    [profile recordRule:identity firedForKey:@"d1 t2"];
+    NSArray* expected = @[flatten, identity, calculate];
+    XCTAssertEqualObjects([profile orderRules:rules forKey:@"d1 t2"], expected);
+    // other classes are not affected
+    XCTAssertEqualObjects([profile orderRules:rules forKey:@"d2 t2"], rules);
+
+    profile.recording = NO;
+    [profile recordRule:calculate firedForKey:@"d1 t2"];
+    [profile recordRule:calculate firedForKey:@"d1 t2"];
+    [profile recordRule:calculate firedForKey:@"d1 t2"];
+    XCTAssertEqualObjects([profile orderRules:rules forKey:@"d1 t2"], expected);
+}
+
+- (void) testOrderCachedUntilCountsChangeIt
+{
+    MTRule* calculate = [MTCalculateRule rule];
+    MTRule* identity = [MTIdentityRule rule];
+    MTRule* flatten = [MTFlattenRule rule];
+    NSArray* rules = @[calculate, identity, flatten];
+
+    MTRuleProfile* profile = [MTRuleProfile new];
+    [profile recordRule:flatten firedForKey:@"d1 t2"];
+    NSArray* order = [profile orderRules:rules forKey:@"d1 t2"];
+    XCTAssertEqualObjects(order, (@[flatten, calculate, identity]));
+    // The first rule firing again does not change the order.
+    [profile recordRule:flatten firedForKey:@"d1 t2"];
+    XCTAssertEqual([profile orderRules:rules forKey:@"d1 t2"], order);
+
+    [profile recordRule:identity firedForKey:@"d1 t2"];
+    XCTAssertEqualObjects([profile orderRules:rules forKey:@"d1 t2"], (@[flatten, identity, calculate]));
+    [profile recordRule:identity firedForKey:@"d1 t2"];
+    [profile recordRule:identity firedForKey:@"d1 t2"];
+    XCTAssertEqualObjects([profile orderRules:rules forKey:@"d1 t2"], (@[identity, flatten, calculate]));
+    // A different list of rules is sorted again.
+    XCTAssertEqualObjects([profile orderRules:@[calculate, flatten] forKey:@"d1 t2"], (@[flatten, calculate]));
+}
+
+- (void) testCombinedRuleSets
+{
+    MTRule* nullAndZero = [MTRewriteRuleSet ruleSetCombining:@[[MTNullRule rule], [MTZeroRule rule]]];
+    MTRule* identityAndZero = [MTRewriteRuleSet ruleSetCombining:@[[MTIdentityRule rule], [MTZeroRule rule]]];
+    XCTAssertEqualObjects(nullAndZero.identifier, @"MTNullRule+MTZeroRule");
+    XCTAssertNotEqualObjects(nullAndZero.identifier, identityAndZero.identifier);
+    MTRule* calculate = [MTCalculateRule rule];
+    NSArray* rules = @[calculate, nullAndZero, identityAndZero];
+
+    // Counts for one combined set do not affect the other.
+    MTRuleProfile* profile = [MTRuleProfile new];
+    [profile recordRule:identityAndZero firedForKey:@"d1 t2"];
+    NSArray* expected = @[identityAndZero, calculate, nullAndZero];
+    XCTAssertEqualObjects([profile orderRules:rules forKey:@"d1 t2"], expected);
+}
+
+- (void) testExportAndLoad
+{
+    MTRule* calculate = [MTCalculateRule rule];
+    MTRule* identity = [MTIdentityRule rule];
+    NSArray* rules = @[calculate, identity];
+
+    MTRuleProfile* profile = [MTRuleProfile new];
+    [profile recordRule:identity firedForKey:@"r t2"];
+    [profile recordPasses:3];
+    MTRuleProfile* loaded = [MTRuleProfile profileWithData:profile.dataRepresentation];
+    XCTAssertNotNil(loaded);
+    XCTAssertEqual(loaded.passes, 3u);
+    NSArray* expected = @[identity, calculate];
+    XCTAssertEqualObjects([loaded orderRules:rules forKey:@"r t2"], expected);
+
+    XCTAssertNil([MTRuleProfile profileWithData:[@"[1, 2]" dataUsingEncoding:NSUTF8StringEncoding]]);
+    XCTAssertNil([MTRuleProfile profileWithData:[@"not json" dataUsingEncoding:NSUTF8StringEncoding]]);
+}
+
+@end
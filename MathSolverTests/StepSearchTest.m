@@ -0,0 +1,128 @@
+//
+//  StepSearchTest.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "MTStepSearch.h"
+#import "MTInfixParser.h"
+#import "MTDistributionRule.h"
+#import "MTReorderTermsRule.h"
+#import "MTCalculateRule.h"
+#import "MTCanonicalizer.h"
+
+@interface StepSearchTest : XCTestCase
+
+@end
+
+@implementation StepSearchTest
+
+- (MTExpression*) parseExpression:(NSString*) expr
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    return [parser parseFromString:expr];
+}
+
+static NSDictionary* getTestData() {
+    return @{
+             @"2(x+3)" : @"((2 * x) + 6)",
+             @"2(x+3) - 4(x - 1)" : @"((-2 * x) + 10)",
+             @"3x + 2 + x" : @"((4 * x) + 2)",
+             @"x*3/3" : @"x",
+             @"5/(2/6)" : @"15",
+             };
+}
+
+- (void) testSearch
+{
+    MTStepSearch* search = [MTStepSearch new];
+    MTReorderTermsRule* reorder = [MTReorderTermsRule rule];
+    NSDictionary* dict = getTestData();
+    for (NSString* testExpr in dict) {
+        MTStepSearchResult* result = [search searchFromExpression:[self parseExpression:testExpr]];
+        XCTAssertTrue(result.reachedNormalForm, @"For %@", testExpr);
+        XCTAssertGreaterThan(result.steps.count, 0u, @"For %@", testExpr);
+        MTStep* last = result.steps.lastObject;
+        NSString* expected = [dict valueForKey:testExpr];
+        XCTAssertEqualObjects(expected, [reorder apply:last.expression].stringValue, @"For %@", testExpr);
+    }
+}
+
+- (void) testAlreadyNormalForm
+{
+    MTStepSearch* search = [MTStepSearch new];
+    MTStepSearchResult* result = [search searchFromExpression:[self parseExpression:@"x + 3"]];
+    XCTAssertTrue(result.reachedNormalForm);
+    XCTAssertEqual(result.steps.count, 0u);
+    XCTAssertNil([search nextStepForExpression:[self parseExpression:@"x + 3"]]);
+}
+
+- (void) testNextStep
+{
+    MTStepSearch* search = [MTStepSearch new];
+    MTStep* step = [search nextStepForExpression:[self parseExpression:@"2(x+3)"]];
+    XCTAssertNotNil(step);
+    XCTAssertTrue([step.rule isKindOfClass:[MTDistributionRule class]], @"Unexpected rule %@", step.rule);
+}
+
+- (void) testParallelMatchesSerial
+{
+    MTStepSearch* parallel = [MTStepSearch new];
+    MTStepSearch* serial = [MTStepSearch new];
+    serial.parallel = NO;
+    // Remove the time limit so that both searches expand the same nodes.
+    parallel.timeLimit = 10;
+    serial.timeLimit = 10;
+    for (NSString* testExpr in getTestData()) {
+        MTExpression* expr = [self parseExpression:testExpr];
+        MTStepSearchResult* r1 = [parallel searchFromExpression:expr];
+        MTStepSearchResult* r2 = [serial searchFromExpression:expr];
+        XCTAssertEqual(r1.nodesExpanded, r2.nodesExpanded, @"For %@", testExpr);
+        XCTAssertEqualObjects([r1.steps valueForKey:@"expression"], [r2.steps valueForKey:@"expression"], @"For %@", testExpr);
+    }
+}
+
+- (void) testDeadEnd
+{
+    // Without distribution no rule applies to 2(x+3), which is not the normal form.
+    MTStepSearch* search = [[MTStepSearch alloc] initWithDivisionRules:@[[MTCalculateRule rule]] polynomialRules:@[[MTCalculateRule rule]]];
+    MTStepSearchResult* result = [search searchFromExpression:[self parseExpression:@"2(x+3)"]];
+    XCTAssertFalse(result.reachedNormalForm);
+    XCTAssertEqual(result.steps.count, 0u);
+    XCTAssertNil([search nextStepForExpression:[self parseExpression:@"2(x+3)"]]);
+    // Steps that only lead to a dead end are not hints either.
+    result = [search searchFromExpression:[self parseExpression:@"(1+1)(x+3)"]];
+    XCTAssertFalse(result.reachedNormalForm);
+    XCTAssertNil([search nextStepForExpression:[self parseExpression:@"(1+1)(x+3)"]]);
+}
+
+- (void) testRationalExpression
+{
+    MTStepSearch* search = [MTStepSearch new];
+    MTReorderTermsRule* reorder = [MTReorderTermsRule rule];
+    MTExpressionCanonicalizer* canonicalizer = [MTCanonicalizerFactory getExpressionCanonicalizer];
+    // The last step divides the numerator and denominator by the leading coefficient of the denominator.
+    MTExpression* expr = [self parseExpression:@"3 / (5x) + 6"];
+    MTStepSearchResult* result = [search searchFromExpression:expr];
+    XCTAssertTrue(result.reachedNormalForm);
+    MTStep* last = result.steps.lastObject;
+    XCTAssertEqualObjects([reorder apply:last.expression], [canonicalizer normalForm:[canonicalizer normalize:expr]]);
+    XCTAssertEqualObjects([reorder apply:last.expression].stringValue, @"(((6 * x) + 3/5) / x)");
+}
+
+- (void) testNodeBudget
+{
+    MTStepSearch* search = [MTStepSearch new];
+    search.maxNodes = 1;
+    MTStepSearchResult* result = [search searchFromExpression:[self parseExpression:@"2(x+3) - 4(x - 1) + 3(x + 2)(x + 1)"]];
+    XCTAssertFalse(result.reachedNormalForm);
+    XCTAssertEqual(result.nodesExpanded, 1u);
+}
+
+@end
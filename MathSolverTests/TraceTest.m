@@ -0,0 +1,169 @@
+//
+//  TraceTest.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "MTTrace.h"
+#import "MTInfixParser.h"
+#import "MTMathListBuilder.h"
+#import "MTExpressionInfo.h"
+#import "MTExpressionAnalysis.h"
+
+@interface TraceTest : XCTestCase
+
+@end
+
+@implementation TraceTest
+
+- (void)tearDown
+{
+    [MTTraceRecorder setSharedRecorder:nil];
+    [super tearDown];
+}
+
+static NSData* dataWithLines(NSArray* lines) {
+    return [[lines componentsJoinedByString:@"\n"] dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+- (void) testRecording
+{
+    MTTraceRecorder* recorder = [MTTraceRecorder new];
+    [MTTraceRecorder setSharedRecorder:recorder];
+    MTInfixParser* parser = [MTInfixParser new];
+    MTExpression* expr = [parser parseToExpressionFromMathList:[MTMathListBuilder buildFromString:@"2x + \\frac{1}{2}"]];
+    MTExpressionInfo* info = [[MTExpressionInfo alloc] initWithExpression:expr input:nil];
+    [MTExpressionAnalysis hasCheckableAnswer:info];
+    [parser parseFromString:@"x+"];
+
+    NSArray* records = recorder.trace.records;
+    // The fraction is not recorded separately.
+    XCTAssertEqual(records.count, 2u);
+    MTTraceRecord* record = records[0];
+    XCTAssertTrue(record.isMathList);
+    XCTAssertEqual(record.entityType, kMTExpression);
+    for (int stage = 0; stage < kMTTraceStageCount; stage++) {
+        XCTAssertGreaterThanOrEqual([record durationForStage:stage], 0, @"Stage %d", stage);
+    }
+    MTTraceRecord* error = records[1];
+    XCTAssertEqualObjects(error.input, @"x+");
+    XCTAssertFalse(error.isMathList);
+    XCTAssertGreaterThanOrEqual([error durationForStage:kMTTraceStageParse], 0);
+    XCTAssertLessThan([error durationForStage:kMTTraceStageNormalize], 0);
+
+    // Entities which are not from the parser are not recorded.
+    [MTTraceRecorder setSharedRecorder:nil];
+    [parser parseFromString:@"x"];
+    XCTAssertEqual(recorder.trace.records.count, 2u);
+}
+
+- (void) testCapacity
+{
+    MTTraceRecorder* recorder = [[MTTraceRecorder alloc] initWithCapacity:2];
+    [MTTraceRecorder setSharedRecorder:recorder];
+    XCTAssertEqual([MTTraceRecorder sharedRecorder], recorder);
+    MTInfixParser* parser = [MTInfixParser new];
+    for (NSString* input in @[@"x", @"x+1", @"x+2"]) {
+        [parser parseFromString:input];
+    }
+    [MTTraceRecorder setSharedRecorder:nil];
+
+    // Only the most recent records are kept, oldest first.
+    NSArray* records = recorder.trace.records;
+    XCTAssertEqual(records.count, 2u);
+    XCTAssertEqualObjects([records[0] input], @"x+1");
+    XCTAssertEqualObjects([records[1] input], @"x+2");
+}
+
+- (void) testReplacedRecorderIsReleased
+{
+    __weak MTTraceRecorder* weakRecorder;
+    @autoreleasepool {
+        MTTraceRecorder* recorder = [MTTraceRecorder new];
+        weakRecorder = recorder;
+        [MTTraceRecorder setSharedRecorder:recorder];
+        [[MTInfixParser new] parseFromString:@"x"];
+        [MTTraceRecorder setSharedRecorder:nil];
+    }
+    XCTAssertNil(weakRecorder);
+    XCTAssertNil([MTTraceRecorder sharedRecorder]);
+}
+
+- (void) testDataRoundTrip
+{
+    MTTrace* trace = [MTTrace traceWithData:dataWithLines(@[ @"MTTrace 1",
+                                                             @"S\t0\t120\t-\t-\t-\tx + 1",
+                                                             @"L\t1\t50\t300\t2000\t10\t\\frac{1}{x}", @"" ])];
+    XCTAssertNotNil(trace);
+    XCTAssertEqual(trace.records.count, 2u);
+    MTTraceRecord* record = trace.records[1];
+    XCTAssertEqualObjects(record.input, @"\\frac{1}{x}");
+    XCTAssertTrue(record.isMathList);
+    XCTAssertEqual(record.entityType, kMTExpression);
+    XCTAssertEqualWithAccuracy([record durationForStage:kMTTraceStageNormalForm], 0.002, 1e-9);
+    XCTAssertEqualWithAccuracy(record.totalDuration, 0.00236, 1e-9);
+    XCTAssertLessThan([trace.records[0] durationForStage:kMTTraceStageAnalysis], 0);
+
+    MTTrace* loaded = [MTTrace traceWithData:trace.dataRepresentation];
+    XCTAssertEqualObjects(loaded.dataRepresentation, trace.dataRepresentation);
+
+    XCTAssertNil([MTTrace traceWithData:dataWithLines(@[ @"MTTrace 2" ])]);
+    XCTAssertNil([MTTrace traceWithData:dataWithLines(@[ @"MTTrace 1", @"S\t0\t120\tx" ])]);
+}
+
+- (void) testPercentiles
+{
+    NSMutableArray* lines = [NSMutableArray arrayWithObject:@"MTTrace 1"];
+    for (int i = 1; i <= 100; i++) {
+        [lines addObject:[NSString stringWithFormat:@"S\t0\t%d\t-\t-\t-\tx+%d", i * 1000, i]];
+    }
+    MTTrace* trace = [MTTrace traceWithData:dataWithLines(lines)];
+    XCTAssertEqualWithAccuracy([trace percentile:0.5 forStage:kMTTraceStageParse], 0.05, 1e-9);
+    XCTAssertEqualWithAccuracy([trace percentile:0.99 forStage:kMTTraceStageParse], 0.099, 1e-9);
+    XCTAssertEqualWithAccuracy([trace percentile:1 forStage:kMTTraceStageParse], 0.1, 1e-9);
+    XCTAssertEqual([trace percentile:0.5 forStage:kMTTraceStageNormalize], 0);
+    XCTAssertTrue([trace.report rangeOfString:@"parse: p50 50.000 p90 90.000 p99 99.000 max 100.000"].location != NSNotFound, @"%@", trace.report);
+}
+
+- (void) testRegressions
+{
+    MTTrace* baseline = [MTTrace traceWithData:dataWithLines(@[ @"MTTrace 1",
+                                                                @"S\t0\t100\t-\t-\t-\tx",
+                                                                @"S\t0\t100\t-\t-\t-\ty",
+                                                                @"S\t0\t1000\t-\t-\t-\tz" ])];
+    MTTrace* current = [MTTrace traceWithData:dataWithLines(@[ @"MTTrace 1",
+                                                               @"S\t0\t150\t-\t-\t-\tx",
+                                                               @"S\t0\t5000\t-\t-\t-\ty",
+                                                               @"L\t0\t5000\t-\t-\t-\tz",
+                                                               @"S\t0\t3000\t-\t-\t-\tw" ])];
+    NSArray* regressions = [current regressionsFromBaseline:baseline factor:2 minimumDifference:0.001];
+    XCTAssertEqual(regressions.count, 1u);
+    XCTAssertEqualObjects([regressions[0] input], @"y");
+}
+
+- (void) testReplay
+{
+    MTTrace* trace = [MTTrace traceWithData:dataWithLines(@[ @"MTTrace 1",
+                                                             @"S\t0\t100\t-\t-\t-\tx + 1",
+                                                             @"L\t1\t100\t100\t100\t100\t2x + \\frac{1}{2}",
+                                                             @"S\t0\t100\t-\t-\t-\tx +" ])];
+    MTTrace* replayed = [MTTrace replayTrace:trace];
+    XCTAssertEqual(replayed.records.count, 3u);
+    MTTraceRecord* record = replayed.records[1];
+    XCTAssertEqualObjects(record.input, @"2x + \\frac{1}{2}");
+    for (int stage = 0; stage < kMTTraceStageCount; stage++) {
+        XCTAssertGreaterThanOrEqual([record durationForStage:stage], 0, @"Stage %d", stage);
+    }
+    XCTAssertGreaterThanOrEqual([replayed.records[0] durationForStage:kMTTraceStageNormalForm], 0);
+    XCTAssertLessThan([replayed.records[0] durationForStage:kMTTraceStageAnalysis], 0);
+    // Parse errors only have the parse stage.
+    XCTAssertLessThan([replayed.records[2] durationForStage:kMTTraceStageNormalize], 0);
+}
+
+@end
@@ -43,6 +43,9 @@ static NSDictionary* getTestData() {
              @"x*(3/1+5)" : @"(x * 8)",
              @"3x/3" : @"(x * 3/3)",
              @"(5+3)/2*(2+3*4/3+3)": @"216/6",
+             @"\\frac12+\\frac12" : @"2/2",
+             @"\\frac12+\\frac14+x" : @"(x + 6/8)",
+             @"\\frac12*\\frac23*3" : @"6/6",
              };
     
 }
@@ -57,6 +60,19 @@ static NSDictionary* getTestData() {
     XCTAssertEqualObjects(@"(x + x + 12)", expr.stringValue, @"Matching the string representation");
 }
 
+- (void)testManyNumbers
+{
+    // More numbers than fit in the stack buffer.
+    NSMutableArray* terms = [NSMutableArray array];
+    for (int i = 1; i <= 20; i++) {
+        [terms addObject:[NSString stringWithFormat:@"%d", i]];
+    }
+    MTInfixParser *parser = [[MTInfixParser alloc] init];
+    MTFlattenRule *flatten = [[MTFlattenRule alloc] init];
+    MTExpression* expr = [_rule apply:[flatten apply:[parser parseFromString:[terms componentsJoinedByString:@"+"]]]];
+    XCTAssertEqualObjects(@"210", expr.stringValue, @"Matching the string representation");
+}
+
 - (void) testRule
 {
     NSDictionary* dict = getTestData();
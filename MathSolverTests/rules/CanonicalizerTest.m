@@ -12,6 +12,61 @@
 #import "MTCanonicalizer.h"
 #import "MTInfixParser.h"
 #import "MTMathListBuilder.h"
+#import "MTRuleProfile.h"
+#import "MTCancellationToken.h"
+
+// Blocks in normalForm: until the gate is signalled, so that concurrent requests are in flight together.
+@interface MTGatedCanonicalizer : NSObject<MTCanonicalizer>
+
+// Signalled when a normalForm: call starts.
+@property (nonatomic, readonly) dispatch_semaphore_t started;
+@property (nonatomic, readonly) dispatch_semaphore_t gate;
+@property (nonatomic, readonly) NSUInteger calls;
+
+@end
+
+@implementation MTGatedCanonicalizer {
+    NSUInteger _calls;
+}
+
+- (id) init
+{
+    self = [super init];
+    if (self) {
+        _started = dispatch_semaphore_create(0);
+        _gate = dispatch_semaphore_create(0);
+    }
+    return self;
+}
+
+- (NSUInteger)calls
+{
+    @synchronized(self) {
+        return _calls;
+    }
+}
+
+- (id<MTMathEntity>)normalize:(id<MTMathEntity>)ex
+{
+    return [[MTCanonicalizerFactory getCanonicalizer:ex] normalize:ex];
+}
+
+- (id<MTMathEntity>)normalForm:(id<MTMathEntity>)ex
+{
+    return [self normalForm:ex cancellationToken:nil];
+}
+
+- (id<MTMathEntity>)normalForm:(id<MTMathEntity>)ex cancellationToken:(MTCancellationToken *)token
+{
+    @synchronized(self) {
+        _calls++;
+    }
+    dispatch_semaphore_signal(_started);
+    dispatch_semaphore_wait(_gate, dispatch_time(DISPATCH_TIME_NOW, 10 * NSEC_PER_SEC));
+    return [[MTCanonicalizerFactory getCanonicalizer:ex] normalForm:ex cancellationToken:token];
+}
+
+@end
 
 @implementation CanonicalizerTest
 
@@ -69,6 +124,287 @@ static NSArray* getTestExpressions() {
 }
 
 // test expressions
+- (void) testParallelExpressionCanonicalizer
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    MTExpressionCanonicalizer* canonicalizer = [MTExpressionCanonicalizer new];
+    for (NSNumber* threshold in @[@1, @4]) {
+        canonicalizer.parallelThreshold = threshold.unsignedIntegerValue;
+        for (NSArray* testCase in getTestExpressions()) {
+            NSString* testExpr = testCase[0];
+            NSString* desc = [NSString stringWithFormat:@"Error for %@ with threshold %@", testExpr, threshold];
+            MTExpression* expr = [parser parseToExpressionFromMathList:[MTMathListBuilder buildFromString:testExpr]];
+            MTExpression* normalForm = [canonicalizer normalForm:[canonicalizer normalize:expr]];
+            XCTAssertEqualObjects(normalForm.stringValue, testCase[2], @"%@", desc);
+        }
+    }
+}
+
+- (void) testProfiledExpressionCanonicalizer
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    MTExpressionCanonicalizer* canonicalizer = [MTExpressionCanonicalizer new];
+    MTRuleProfile* profile = [MTRuleProfile new];
+    canonicalizer.ruleProfile = profile;
+    // The first round learns the order, the second uses it. Both should give the same normal forms.
+    for (int round = 0; round < 2; round++) {
+        for (NSArray* testCase in getTestExpressions()) {
+            NSString* testExpr = testCase[0];
+            NSString* desc = [NSString stringWithFormat:@"Error for %@ in round %d", testExpr, round];
+            MTExpression* expr = [parser parseToExpressionFromMathList:[MTMathListBuilder buildFromString:testExpr]];
+            MTExpression* normalForm = [canonicalizer normalForm:[canonicalizer normalize:expr]];
+            XCTAssertEqualObjects(normalForm.stringValue, testCase[2], @"%@", desc);
+        }
+    }
+    XCTAssertGreaterThan(profile.passes, 0u);
+}
+
+// The number of passes made to canonicalize the test expressions with the given profile, which is not changed.
+static NSUInteger passesWithProfile(MTRuleProfile* profile) {
+    MTInfixParser *parser = [MTInfixParser new];
+    MTExpressionCanonicalizer* canonicalizer = [MTExpressionCanonicalizer new];
+    canonicalizer.ruleProfile = profile;
+    profile.recording = NO;
+    NSUInteger before = profile.passes;
+    for (NSArray* testCase in getTestExpressions()) {
+        MTExpression* expr = [parser parseToExpressionFromMathList:[MTMathListBuilder buildFromString:testCase[0]]];
+        [canonicalizer normalForm:[canonicalizer normalize:expr]];
+    }
+    return profile.passes - before;
+}
+
+- (void) testLearnedProfilePasses
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    MTExpressionCanonicalizer* canonicalizer = [MTExpressionCanonicalizer new];
+    MTRuleProfile* learning = [MTRuleProfile new];
+    canonicalizer.ruleProfile = learning;
+    for (NSArray* testCase in getTestExpressions()) {
+        MTExpression* expr = [parser parseToExpressionFromMathList:[MTMathListBuilder buildFromString:testCase[0]]];
+        [canonicalizer normalForm:[canonicalizer normalize:expr]];
+    }
+    MTRuleProfile* learned = [MTRuleProfile profileWithData:learning.dataRepresentation];
+
+    // An empty profile keeps the default order of the rules.
+    NSUInteger defaultPasses = passesWithProfile([MTRuleProfile new]);
+    NSUInteger learnedPasses = passesWithProfile(learned);
+    XCTAssertGreaterThan(defaultPasses, 0u);
+    XCTAssertLessThanOrEqual(learnedPasses, defaultPasses);
+}
+
+// A sum of products of the given width, i.e. (x + 1)(2x + 1)/(y + 1) + (x + 2)(2x + 2)/(y + 2) + ...
+static MTExpression* getWideExpression(NSUInteger width) {
+    NSMutableString* str = [NSMutableString string];
+    for (NSUInteger i = 1; i <= width; i++) {
+        if (i > 1) {
+            [str appendString:@" + "];
+        }
+        [str appendFormat:@"(x + %lu)(%lux + %lu)/(y + %lu)", (unsigned long)i, (unsigned long)(i % 3 + 1), (unsigned long)i, (unsigned long)(i % 2 + 1)];
+    }
+    MTInfixParser *parser = [MTInfixParser new];
+    MTExpression* expr = [parser parseFromString:str];
+    return [[MTCanonicalizerFactory getExpressionCanonicalizer] normalize:expr];
+}
+
+- (void) testParallelMatchesSerial
+{
+    MTExpressionCanonicalizer* serial = [MTCanonicalizerFactory getExpressionCanonicalizer];
+    MTExpressionCanonicalizer* parallel = [MTExpressionCanonicalizer new];
+    parallel.parallelThreshold = 8;
+    MTExpression* expr = getWideExpression(16);
+    XCTAssertEqualObjects([parallel normalForm:expr], [serial normalForm:expr]);
+}
+
+- (void) testPerformanceWideExpressionSerial
+{
+    MTExpressionCanonicalizer* canonicalizer = [MTCanonicalizerFactory getExpressionCanonicalizer];
+    MTExpression* expr = getWideExpression(32);
+    [self measureBlock:^{
+        [canonicalizer normalForm:expr];
+    }];
+}
+
+// The best of 3 runs of normalForm: in seconds.
+static CFAbsoluteTime bestTime(MTExpressionCanonicalizer* canonicalizer, MTExpression* expr) {
+    CFAbsoluteTime best = DBL_MAX;
+    for (int i = 0; i < 3; i++) {
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        [canonicalizer normalForm:expr];
+        best = MIN(best, CFAbsoluteTimeGetCurrent() - start);
+    }
+    return best;
+}
+
+// Measures the speedup of the parallel mode over the serial one for growing widths and logs it with the number of cores, so
+// that runs on machines with different numbers of cores can be compared.
+- (void) testParallelScaling
+{
+    MTExpressionCanonicalizer* serial = [MTExpressionCanonicalizer new];
+    MTExpressionCanonicalizer* parallel = [MTExpressionCanonicalizer new];
+    parallel.parallelThreshold = 8;
+    NSMutableString* report = [NSMutableString stringWithFormat:@"%lu cores\n", (unsigned long) [NSProcessInfo processInfo].activeProcessorCount];
+    for (NSNumber* width in @[@4, @8, @16, @32]) {
+        MTExpression* expr = getWideExpression(width.unsignedIntegerValue);
+        XCTAssertEqualObjects([parallel normalForm:expr], [serial normalForm:expr], @"Width %@", width);
+        CFAbsoluteTime serialTime = bestTime(serial, expr);
+        CFAbsoluteTime parallelTime = bestTime(parallel, expr);
+        [report appendFormat:@"width %@: serial %.1f ms parallel %.1f ms speedup %.2f\n", width, serialTime * 1000,
+         parallelTime * 1000, serialTime / parallelTime];
+    }
+    NSLog(@"%@", report);
+}
+
+- (void) testPerformanceWideExpressionParallel
+{
+    MTExpressionCanonicalizer* canonicalizer = [MTExpressionCanonicalizer new];
+    canonicalizer.parallelThreshold = 8;
+    MTExpression* expr = getWideExpression(32);
+    [self measureBlock:^{
+        [canonicalizer normalForm:expr];
+    }];
+}
+
+// Typical student answers. Compare across changes to the rules for the cost of a normalForm: call.
+- (void) testPerformanceNormalForm
+{
+    MTExpressionCanonicalizer* canonicalizer = [MTCanonicalizerFactory getExpressionCanonicalizer];
+    MTInfixParser *parser = [MTInfixParser new];
+    NSMutableArray* normalized = [NSMutableArray array];
+    for (NSArray* testCase in getTestExpressions()) {
+        MTExpression* expr = [parser parseToExpressionFromMathList:[MTMathListBuilder buildFromString:testCase[0]]];
+        [normalized addObject:[canonicalizer normalize:expr]];
+    }
+    [self measureBlock:^{
+        for (int i = 0; i < 20; i++) {
+            for (MTExpression* expr in normalized) {
+                [canonicalizer normalForm:expr];
+            }
+        }
+    }];
+}
+
+- (void) testCoalescingCanonicalizer
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    MTExpressionCanonicalizer* canonicalizer = [MTCanonicalizerFactory getExpressionCanonicalizer];
+    MTCoalescingCanonicalizer* coalescing = [MTCoalescingCanonicalizer new];
+    for (NSArray* testCase in getTestExpressions()) {
+        MTExpression* expr = [parser parseToExpressionFromMathList:[MTMathListBuilder buildFromString:testCase[0]]];
+        MTExpression* normalized = [coalescing normalize:expr];
+        XCTAssertEqualObjects(normalized, [canonicalizer normalize:expr], @"Error for %@", testCase[0]);
+        XCTAssertEqualObjects([coalescing normalForm:normalized].stringValue, testCase[2], @"Error for %@", testCase[0]);
+    }
+    // Nothing was concurrent.
+    XCTAssertEqual(coalescing.coalescedWaiters, 0u);
+}
+
+- (MTExpression*) normalizedExpression:(NSString*) str
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    return [[MTCanonicalizerFactory getExpressionCanonicalizer] normalize:[parser parseToExpressionFromMathList:[MTMathListBuilder buildFromString:str]]];
+}
+
+- (BOOL) waitForWaiters:(NSUInteger) waiters ofCanonicalizer:(MTCoalescingCanonicalizer*) coalescing
+{
+    NSDate* deadline = [NSDate dateWithTimeIntervalSinceNow:10];
+    while (coalescing.coalescedWaiters < waiters) {
+        if ([deadline timeIntervalSinceNow] < 0) {
+            return NO;
+        }
+        [NSThread sleepForTimeInterval:0.001];
+    }
+    return YES;
+}
+
+- (void) testConcurrentCoalescedRequests
+{
+    MTGatedCanonicalizer* gated = [MTGatedCanonicalizer new];
+    MTCoalescingCanonicalizer* coalescing = [[MTCoalescingCanonicalizer alloc] initWithCanonicalizer:gated];
+    NSString* str = @"((x/3) + x)/(2(x+1)) + 2x/(x+1) + (1/y)/(1 + 1/y)";
+    MTExpressionCanonicalizer* canonicalizer = [MTCanonicalizerFactory getExpressionCanonicalizer];
+    MTExpression* expected = [canonicalizer normalForm:[self normalizedExpression:str]];
+    const NSUInteger requests = 16;
+    NSMutableArray* results = [NSMutableArray array];
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    void (^request)(void) = ^{
+        // Each request parses its own copy of the expression.
+        id<MTMathEntity> normalForm = [coalescing normalForm:[self normalizedExpression:str]];
+        @synchronized(results) {
+            [results addObject:normalForm];
+        }
+    };
+    dispatch_group_async(group, queue, request);
+    // The first request is computing and blocked on the gate.
+    dispatch_semaphore_wait(gated.started, DISPATCH_TIME_FOREVER);
+    for (NSUInteger i = 1; i < requests; i++) {
+        dispatch_group_async(group, queue, request);
+    }
+    XCTAssertTrue([self waitForWaiters:requests - 1 ofCanonicalizer:coalescing]);
+    dispatch_semaphore_signal(gated.gate);
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+    XCTAssertEqual(coalescing.coalescedWaiters, requests - 1);
+    XCTAssertEqual(gated.calls, 1u);
+    XCTAssertEqual(results.count, requests);
+    for (id<MTMathEntity> result in results) {
+        XCTAssertEqualObjects(result, expected);
+    }
+}
+
+- (void) testCoalescingRequiresSameRanges
+{
+    MTGatedCanonicalizer* gated = [MTGatedCanonicalizer new];
+    MTCoalescingCanonicalizer* coalescing = [[MTCoalescingCanonicalizer alloc] initWithCanonicalizer:gated];
+    MTExpression* implicit = [self normalizedExpression:@"2x"];
+    MTExpression* explicit = [self normalizedExpression:@"2*x"];
+    XCTAssertEqualObjects(implicit, explicit);
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_group_async(group, queue, ^{
+        [coalescing normalForm:implicit];
+    });
+    dispatch_semaphore_wait(gated.started, DISPATCH_TIME_FOREVER);
+    dispatch_group_async(group, queue, ^{
+        [coalescing normalForm:explicit];
+    });
+    // The ranges differ, so the second request computes its own result while the first one is in flight.
+    XCTAssertEqual(dispatch_semaphore_wait(gated.started, dispatch_time(DISPATCH_TIME_NOW, 10 * NSEC_PER_SEC)), 0);
+    dispatch_semaphore_signal(gated.gate);
+    dispatch_semaphore_signal(gated.gate);
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    XCTAssertEqual(gated.calls, 2u);
+    XCTAssertEqual(coalescing.coalescedWaiters, 0u);
+}
+
+- (void) testCancelledWaiter
+{
+    MTGatedCanonicalizer* gated = [MTGatedCanonicalizer new];
+    MTCoalescingCanonicalizer* coalescing = [[MTCoalescingCanonicalizer alloc] initWithCanonicalizer:gated];
+    MTExpression* expr = [self normalizedExpression:@"2(x + 3)"];
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_group_t computing = dispatch_group_create();
+    dispatch_group_async(computing, queue, ^{
+        [coalescing normalForm:expr];
+    });
+    dispatch_semaphore_wait(gated.started, DISPATCH_TIME_FOREVER);
+
+    MTCancellationToken* token = [MTCancellationToken token];
+    __block id<MTMathEntity> result = expr;
+    dispatch_group_t waiting = dispatch_group_create();
+    dispatch_group_async(waiting, queue, ^{
+        result = [coalescing normalForm:expr cancellationToken:token];
+    });
+    XCTAssertTrue([self waitForWaiters:1 ofCanonicalizer:coalescing]);
+    [token cancel];
+    // The waiter returns while the computation it waits for is still blocked.
+    XCTAssertEqual(dispatch_group_wait(waiting, dispatch_time(DISPATCH_TIME_NOW, 5 * NSEC_PER_SEC)), 0);
+    XCTAssertNil(result);
+    dispatch_semaphore_signal(gated.gate);
+    dispatch_group_wait(computing, DISPATCH_TIME_FOREVER);
+    XCTAssertEqual(gated.calls, 1u);
+}
+
 static NSArray* getTestEquations() {
     return @[
              @[ @"x = 0", @"x = 0", @"x = 0" ],
@@ -104,4 +440,66 @@ static NSArray* getTestEquations() {
         XCTAssertEqualObjects(normalForm.stringValue, testCase[2], @"%@", desc);
     }
 }
+
+static NSArray* getLowDegreeEquations() {
+    return @[ @"x = 0", @"x = 3", @"5x - 3 = 4x - 1", @"3x = 0", @"3x + 5 = 2", @"-2x = 3", @"x/2 = 3", @"0.3x = 1",
+              @"(x + 3)(2x - 1) = 2x - 5", @"xx = 4", @"2x(x - 3) = -(x + 1)", @"\\frac{x}{3} - \\frac12 = 2x", @"3 = 2",
+              @"x = x", @"(x + 1)/3 = x/2", @"x/0 = 1", @"x(x + 1)(x - 1) = 0", @"x + y = 1" ];
+}
+
+- (void) testEquationFastPathMatchesRules
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    MTEquationCanonicalizer* canonicalizer = [MTCanonicalizerFactory getEquationCanonicalizer];
+    for (NSString* testExpr in getLowDegreeEquations()) {
+        NSString* desc = [NSString stringWithFormat:@"Error for %@", testExpr];
+        MTMathList* ml = [MTMathListBuilder buildFromString:testExpr];
+        MTEquation* eq = [parser parseToEquationFromMathList:ml];
+        XCTAssertNotNil(eq, @"%@", desc);
+
+        MTEquation* normalized = [canonicalizer normalize:eq];
+        MTEquation* normalForm = [canonicalizer normalForm:normalized];
+        MTEquation* rulesNormalForm = [canonicalizer normalFormUsingRules:normalized];
+        XCTAssertEqualObjects(normalForm, rulesNormalForm, @"%@", desc);
+        XCTAssertEqualObjects(normalForm.stringValue, rulesNormalForm.stringValue, @"%@", desc);
+    }
+}
+
+static NSArray* getNormalizedEquations(NSArray* equations) {
+    MTInfixParser *parser = [MTInfixParser new];
+    MTEquationCanonicalizer* canonicalizer = [MTCanonicalizerFactory getEquationCanonicalizer];
+    NSMutableArray* normalized = [NSMutableArray arrayWithCapacity:equations.count];
+    for (NSString* testExpr in equations) {
+        MTEquation* eq = [parser parseToEquationFromMathList:[MTMathListBuilder buildFromString:testExpr]];
+        [normalized addObject:[canonicalizer normalize:eq]];
+    }
+    return normalized;
+}
+
+// Compare with testPerformanceEquationNormalFormUsingRules for the speedup of the fast path.
+- (void) testPerformanceEquationNormalForm
+{
+    MTEquationCanonicalizer* canonicalizer = [MTCanonicalizerFactory getEquationCanonicalizer];
+    NSArray* equations = getNormalizedEquations(getLowDegreeEquations());
+    [self measureBlock:^{
+        for (int i = 0; i < 100; i++) {
+            for (MTEquation* eq in equations) {
+                [canonicalizer normalForm:eq];
+            }
+        }
+    }];
+}
+
+- (void) testPerformanceEquationNormalFormUsingRules
+{
+    MTEquationCanonicalizer* canonicalizer = [MTCanonicalizerFactory getEquationCanonicalizer];
+    NSArray* equations = getNormalizedEquations(getLowDegreeEquations());
+    [self measureBlock:^{
+        for (int i = 0; i < 100; i++) {
+            for (MTEquation* eq in equations) {
+                [canonicalizer normalFormUsingRules:eq];
+            }
+        }
+    }];
+}
 @end
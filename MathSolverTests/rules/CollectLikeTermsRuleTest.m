@@ -63,6 +63,7 @@ static NSDictionary* getTestDataForFlatten() {
              @"4xy - 3xy" : @"(1 * x * y)",
              @"4xy - 5xy" : @"(-1 * x * y)",
              @"4xy - xy" : @"(3 * x * y)",
+             @"a*b*c*d*e*f*g*h + 2h*g*f*e*d*c*b*a" : @"(3 * a * b * c * d * e * f * g * h)",
              };
     
 }
@@ -92,6 +93,21 @@ static NSDictionary* getTestDataForFlatten() {
     }
 }
 
+- (void) testPerformanceWideSum
+{
+    NSMutableString* str = [NSMutableString stringWithString:@"x"];
+    for (int i = 1; i < 500; i++) {
+        [str appendFormat:@" + %d*%c*%c + %d", i, 'a' + i % 5, 'a' + i % 7, i];
+    }
+    MTInfixParser *parser = [MTInfixParser new];
+    MTExpression* expr = [_canonicalizer normalize:[parser parseFromString:str]];
+    [self measureBlock:^{
+        for (int i = 0; i < 100; i++) {
+            [_rule apply:expr];
+        }
+    }];
+}
+
 - (void)testRuleAfterDistribution
 {
     MTInfixParser *parser = [[MTInfixParser alloc] init];
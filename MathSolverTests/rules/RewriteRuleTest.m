@@ -0,0 +1,112 @@
+//
+//  RewriteRuleTest.m
+//
+//  Created by Kostub Deshmukh on 10/19/26.
+//  Copyright (c) 2026 Kostub Deshmukh.
+//
+//  This software may be modified and distributed under the terms of the
+//  MIT license. See the LICENSE file for details.
+//
+
+#import <XCTest/XCTest.h>
+
+#import "MTRewriteRule.h"
+#import "MTInfixParser.h"
+#import "MTExpression.h"
+#import "MTFlattenRule.h"
+#import "MTNullRule.h"
+#import "MTIdentityRule.h"
+#import "MTZeroRule.h"
+
+@interface RewriteRuleTest : XCTestCase
+
+@end
+
+@implementation RewriteRuleTest
+
+- (MTExpression*) parseExpression:(NSString*) expr
+{
+    MTInfixParser *parser = [MTInfixParser new];
+    return [[MTFlattenRule rule] apply:[parser parseFromString:expr]];
+}
+
+- (MTRewriteRuleSet*) ruleSetWithStrings:(NSArray*) strings
+{
+    NSMutableArray* rules = [NSMutableArray array];
+    for (NSString* str in strings) {
+        MTRewriteRule* rule = [MTRewriteRule ruleWithString:str];
+        XCTAssertNotNil(rule, @"For %@", str);
+        [rules addObject:rule];
+    }
+    return [MTRewriteRuleSet ruleSetWithRules:rules];
+}
+
+// rules, expression, result
+static NSArray* getTestData() {
+    return @[
+             @[ @[ @"(- a a) => 0" ], @"x - x", @"0" ],
+             @[ @[ @"(- a a) => 0" ], @"x - y", @"(x - y)" ],
+             @[ @[ @"(- a a) => 0" ], @"(x + 1) - (x + 1)", @"0" ],
+             @[ @[ @"(_ (_ a)) => a" ], @"-(-x)", @"x" ],
+             @[ @[ @"(* a:num (+ b c)) => (+ (* a b) (* a c))" ], @"2*(x+1)", @"((2 * x) + (2 * 1))" ],
+             @[ @[ @"(* a:num (+ b c)) => (+ (* a b) (* a c))" ], @"x*(x+1)", @"(x * (x + 1))" ],
+             @[ @[ @"(+ a:var ...r) => (+ ...r)" ], @"3 + x + y", @"(3 + y)" ],
+             @[ @[ @"(+ a:var ...r) => (+ ...r)" ], @"x + 3", @"3" ],
+             @[ @[ @"(+ a:var ...r) => (+ ...r)" ], @"3 + 4", @"(3 + 4)" ],
+             @[ @[ @"(op a:op ...r) => a" ], @"x * (y - 2)", @"(y - 2)" ],
+             // The first rule that matches is used.
+             @[ @[ @"(* a 0) => 0", @"(* a b) => b" ], @"x * 0", @"0" ],
+             @[ @[ @"(* a 0) => 0", @"(* a b) => b" ], @"x * y", @"y" ],
+             @[ @[ @"(* a 0) => 0", @"(* a b) => b" ], @"x + y", @"(x + y)" ],
+             ];
+}
+
+- (void) testRules
+{
+    for (NSArray* testCase in getTestData()) {
+        MTRewriteRuleSet* ruleSet = [self ruleSetWithStrings:testCase[0]];
+        MTExpression* expr = [ruleSet apply:[self parseExpression:testCase[1]]];
+        XCTAssertEqualObjects(expr.stringValue, testCase[2], @"For %@ with %@", testCase[1], testCase[0]);
+    }
+}
+
+- (void) testInvalidRules
+{
+    NSArray* invalid = @[ @"x => y", @"(+ a b)", @"(+ a b) => c", @"(+ a ...r ...s) => a", @"(+ a b ...r) => a",
+                          @"(% a b) => a", @"(+ a b) => (op a b)", @"(+ a ...r) => r", @"(+ a b) => a b", @"(+) => 0",
+                          @"(+ a:int b) => a", @"(+ a b => a" ];
+    for (NSString* str in invalid) {
+        XCTAssertNil([MTRewriteRule ruleWithString:str], @"For %@", str);
+    }
+    MTRewriteRule* rule = [MTRewriteRule ruleWithString:@"(+ 0 ...r) => (+ ...r)"];
+    XCTAssertEqualObjects(rule.string, @"(+ 0 ...r) => (+ ...r)");
+}
+
+- (void) testCombinedRuleSet
+{
+    MTRewriteRuleSet* combined = [MTRewriteRuleSet ruleSetCombining:@[[MTNullRule rule], [MTIdentityRule rule], [MTZeroRule rule]]];
+    XCTAssertEqual(combined.rules.count, 4u);
+    // One rewrite per node, in the order of the rule sets.
+    MTExpression* expr = [combined apply:[self parseExpression:@"x*1*0"]];
+    XCTAssertEqualObjects(expr.stringValue, @"(x * 0)");
+    XCTAssertEqualObjects([combined apply:expr].stringValue, @"0");
+    MTExpression* withNull = [MTOperator operatorWithType:kMTAddition args:[self parseExpression:@"x*1"] :[MTNull null]];
+    XCTAssertEqualObjects([combined apply:withNull], [MTNull null]);
+}
+
+- (void) testPerformanceCombinedRuleSet
+{
+    MTRewriteRuleSet* combined = [MTRewriteRuleSet ruleSetCombining:@[[MTNullRule rule], [MTIdentityRule rule], [MTZeroRule rule]]];
+    NSMutableString* str = [NSMutableString stringWithString:@"x"];
+    for (int i = 1; i < 200; i++) {
+        [str appendFormat:@" + %d*(x + %d)", i, i % 3];
+    }
+    MTExpression* expr = [self parseExpression:str];
+    [self measureBlock:^{
+        for (int i = 0; i < 100; i++) {
+            [combined apply:expr];
+        }
+    }];
+}
+
+@end